@@ -0,0 +1,56 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <ThreadPool/ThreadPool.h>
+
+// Helpers shared by the benchmarks
+namespace BenchUtils
+{
+    // Value at `percentile`, within [0, 1], of unsorted samples; 0 without any
+    inline double Percentile(std::vector<double> values, double percentile)
+    {
+        if (values.empty()) return 0.;
+        std::sort(values.begin(), values.end());
+        const auto index = static_cast<size_t>(percentile * static_cast<double>(values.size() - 1));
+        return values[index];
+    }
+
+    // Recursive fibonacci, every call but the leaves forks its two halves as jobs and waits for them
+    struct FibData
+    {
+        JobSystem::Internal::ThreadPool * threadPool;
+        int n;
+        int64_t result;
+    };
+
+    inline void FibJobFunction(JobSystem::Internal::Job *, void * rawData)
+    {
+        auto * data = static_cast<FibData *>(rawData);
+        if (data->n < 2) {
+            data->result = data->n;
+            return;
+        }
+
+        JobSystem::Internal::ThreadPool & threadPool = *data->threadPool;
+        FibData halves[2] = { { &threadPool, data->n - 1, 0 }, { &threadPool, data->n - 2, 0 } };
+        JobSystem::Internal::Job * root = threadPool.CreateJob([]() {});
+        for (FibData & half : halves) { threadPool.Schedule(threadPool.CreateJobAsChild(root, &FibJobFunction, &half)); }
+        threadPool.Schedule(root);
+        threadPool.Wait(root);
+        data->result = halves[0].result + halves[1].result;
+    }
+
+    inline int MaxWorkers() { return static_cast<int>(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2); }
+
+    // One run per power of two number of workers, up to the number of cores
+    inline void WorkerCounts(benchmark::internal::Benchmark * benchmark)
+    {
+        for (int numWorkers = 1; numWorkers <= MaxWorkers(); numWorkers *= 2) { benchmark->Arg(numWorkers); }
+    }
+} // namespace BenchUtils
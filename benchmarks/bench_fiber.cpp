@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include <ThreadPool/Fiber.h>
+#include <ThreadPool/ThreadPool.h>
+
+#include "BenchUtils.h"
+
+using BenchUtils::FibData;
+using BenchUtils::FibJobFunction;
+using JobSystem::Fiber;
+using JobSystem::Internal::Job;
+using JobSystem::Internal::ThreadPool;
+using JobSystem::Internal::ThreadPoolConfig;
+
+namespace
+{
+    struct PingPong
+    {
+        Fiber * caller;
+        Fiber * callee;
+    };
+
+    void PingPongEntry(void * rawData)
+    {
+        auto * data = static_cast<PingPong *>(rawData);
+        for (;;) { data->callee->SwitchTo(*data->caller); }
+    }
+
+    // every inner node of the recursion, fib(n + 1) - 1 of them, creates a root and two children
+    int64_t NumFibJobs(int n)
+    {
+        int64_t previous = 0, current = 1;
+        for (int i = 0; i < n; ++i) {
+            const int64_t next = previous + current;
+            previous = current;
+            current = next;
+        }
+        return 3 * (current - 1) + 1;
+    }
+} // namespace
+
+// One iteration is a round trip, two context switches
+static void BM_FiberSwitch(benchmark::State & state)
+{
+    if (!Fiber::isSupported) {
+        state.SkipWithError("no fibers on this platform");
+        return;
+    }
+
+    Fiber caller;
+    PingPong data = { &caller, nullptr };
+    Fiber callee(16 * 1024, &PingPongEntry, &data);
+    data.callee = &callee;
+
+    for (auto _ : state) { caller.SwitchTo(callee); }
+}
+
+BENCHMARK(BM_FiberSwitch);
+
+// Every level of the recursion waits for its halves: `fibers` 0 nests the waits on the worker stacks, 1 suspends them
+static void BM_ForkJoinFib(benchmark::State & state)
+{
+    ThreadPoolConfig config;
+    config.useFibers = state.range(0) != 0;
+    const int n = static_cast<int>(state.range(1));
+    ThreadPool threadPool(static_cast<size_t>(BenchUtils::MaxWorkers()), config);
+
+    int64_t numJobs = 0;
+    for (auto _ : state) {
+        FibData data = { &threadPool, n, 0 };
+        Job * job = threadPool.CreateJob(&FibJobFunction, &data);
+        threadPool.Schedule(job);
+        threadPool.Wait(job);
+        benchmark::DoNotOptimize(data.result);
+        numJobs += NumFibJobs(n);
+    }
+    state.counters["jobs"] = benchmark::Counter(static_cast<double>(numJobs), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_ForkJoinFib)->ArgNames({ "fibers", "n" })->Args({ 0, 20 })->Args({ 1, 20 })->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+#include <ThreadPool/ThreadPool.h>
+
+using JobSystem::Internal::IdlePolicy;
+using JobSystem::Internal::Job;
+using JobSystem::Internal::ThreadPool;
+using JobSystem::Internal::ThreadPoolConfig;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct WakeUpData
+    {
+        std::atomic<int64_t> startedAt{ 0 };
+    };
+
+    void RecordStartJobFunction(Job *, void * rawData)
+    {
+        auto * data = reinterpret_cast<WakeUpData *>(rawData);
+        data->startedAt.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+    }
+
+    double ProcessCpuSeconds() { return static_cast<double>(std::clock()) / CLOCKS_PER_SEC; }
+} // namespace
+
+// Schedule a job after the pool went idle and measure until a worker picks it up (the main thread never executes it).
+// `idle_cpu` is the CPU time the whole process burnt while idling, in cores.
+static void BM_IdleWakeUp(benchmark::State & state)
+{
+    const auto idlePolicy = static_cast<IdlePolicy>(state.range(0));
+    const auto idleTime = std::chrono::milliseconds(state.range(1));
+    const size_t numThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2;
+
+    ThreadPoolConfig config;
+    config.idlePolicy = idlePolicy;
+    ThreadPool threadPool(numThreads, config);
+
+    double idleCpu = 0.;
+    double idleWall = 0.;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        const double cpuBefore = ProcessCpuSeconds();
+        const auto wallBefore = Clock::now();
+        std::this_thread::sleep_for(idleTime);
+        idleCpu += ProcessCpuSeconds() - cpuBefore;
+        idleWall += std::chrono::duration<double>(Clock::now() - wallBefore).count();
+
+        WakeUpData data;
+        Job * job = threadPool.CreateJob(&RecordStartJobFunction, &data);
+        state.ResumeTiming();
+
+        const int64_t scheduledAt = Clock::now().time_since_epoch().count();
+        threadPool.Schedule(job);
+        while (data.startedAt.load(std::memory_order_acquire) == 0) { std::this_thread::yield(); }
+
+        state.SetIterationTime(std::chrono::duration<double>(Clock::duration(data.startedAt - scheduledAt)).count());
+    }
+
+    state.counters["idle_cpu"] = idleWall > 0. ? idleCpu / idleWall : 0.;
+}
+
+BENCHMARK(BM_IdleWakeUp)
+  ->ArgNames({ "policy", "idle_ms" })
+  ->Args({ static_cast<int64_t>(IdlePolicy::Spin), 10 })
+  ->Args({ static_cast<int64_t>(IdlePolicy::Yield), 10 })
+  ->Args({ static_cast<int64_t>(IdlePolicy::Adaptive), 10 })
+  ->UseManualTime()
+  ->Iterations(50);
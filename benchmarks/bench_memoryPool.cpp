@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+
+#include <ThreadPool/JobAllocator.h>
+#include <ThreadPool/MemoryPoolAllocator.h>
+#include <ThreadPool/ObjectPool.h>
+
+namespace
+{
+  constexpr size_t numElements = 4096;
+  constexpr size_t elementSize = 128;
+  constexpr int batchSize = 16;
+
+  struct Payload
+  {
+    char data[elementSize];
+  };
+} // namespace
+
+// Every thread takes a few blocks from one shared pool and gives them back, the head is the contended spot
+static void BM_MemoryPoolAllocator_Contention(benchmark::State & state)
+{
+  static JobSystem::MemoryPoolAllocator * allocator = nullptr;
+  if (state.thread_index() == 0) allocator = new JobSystem::MemoryPoolAllocator(numElements, elementSize);
+
+  void * blocks[batchSize] = {};
+  for (auto _ : state) {
+    for (void *& block : blocks) { block = allocator->Allocate(); }
+    for (void * block : blocks) {
+      if (block) allocator->Deallocate(block);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * batchSize);
+
+  if (state.thread_index() == 0) {
+    delete allocator;
+    allocator = nullptr;
+  }
+}
+
+// The per worker allocator on its owner path, what the pool uses for jobs created on a worker
+static void BM_JobAllocator_Owner(benchmark::State & state)
+{
+  JobSystem::JobAllocator allocator(numElements, elementSize);
+
+  void * blocks[batchSize] = {};
+  for (auto _ : state) {
+    for (void *& block : blocks) { block = allocator.Allocate(); }
+    for (void * block : blocks) { allocator.Deallocate(block); }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * batchSize);
+}
+
+// Same pattern through the per thread magazines, the shared pool only sees every half magazine
+static void BM_ObjectPool_Contention(benchmark::State & state)
+{
+  static JobSystem::ObjectPool<Payload> * pool = nullptr;
+  if (state.thread_index() == 0) pool = new JobSystem::ObjectPool<Payload>(numElements);
+
+  Payload * objects[batchSize] = {};
+  for (auto _ : state) {
+    for (Payload *& object : objects) { object = pool->Create(); }
+    for (Payload * object : objects) { pool->Destroy(object); }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * batchSize);
+
+  if (state.thread_index() == 0) {
+    delete pool;
+    pool = nullptr;
+  }
+}
+
+BENCHMARK(BM_MemoryPoolAllocator_Contention)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_ObjectPool_Contention)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_JobAllocator_Owner);
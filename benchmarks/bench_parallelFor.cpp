@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include <ThreadPool/ParallelFor.h>
+
+#include "BenchUtils.h"
+
+using BenchUtils::MaxWorkers;
+using BenchUtils::WorkerCounts;
+using JobSystem::Internal::AutoSplitter;
+using JobSystem::Internal::CountSplitter;
+using JobSystem::Internal::DataSizeSplitter;
+using JobSystem::Internal::Job;
+using JobSystem::Internal::ParallelFor;
+using JobSystem::Internal::ThreadPool;
+
+namespace
+{
+    constexpr size_t elementCount = 1 << 20;
+    constexpr size_t leafSize = 256;
+
+    void Process(const std::vector<float> & input, std::vector<float> & output, size_t begin, size_t count)
+    {
+        for (size_t i = begin; i < begin + count; ++i) { output[i] = std::sqrt(input[i]) * 0.5f + 1.f; }
+    }
+
+    enum SplitterKind
+    {
+        Count,
+        DataSize,
+        Auto,
+    };
+
+    void RunParallelFor(ThreadPool & threadPool, const std::vector<float> & input, std::vector<float> & output, SplitterKind splitterKind)
+    {
+        auto function = [&input, &output](size_t begin, size_t count) { Process(input, output, begin, count); };
+        Job * job = nullptr;
+        switch (splitterKind) {
+            case Count: job = ParallelFor(threadPool, 0, elementCount, function, CountSplitter(leafSize)); break;
+            case DataSize: job = ParallelFor(threadPool, 0, elementCount, function, DataSizeSplitter(32 * 1024, sizeof(float))); break;
+            case Auto: job = ParallelFor(threadPool, 0, elementCount, function, AutoSplitter(threadPool, elementCount, leafSize)); break;
+        }
+        threadPool.Schedule(job);
+        threadPool.Wait(job);
+    }
+} // namespace
+
+// Scaling over the number of workers, the main thread helps in Wait() as well
+static void BM_ParallelFor(benchmark::State & state)
+{
+    const auto splitterKind = static_cast<SplitterKind>(state.range(0));
+    ThreadPool threadPool(static_cast<size_t>(state.range(1)));
+    std::vector<float> input(elementCount, 2.f);
+    std::vector<float> output(elementCount);
+
+    for (auto _ : state) {
+        RunParallelFor(threadPool, input, output, splitterKind);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elementCount));
+}
+
+// What the splitters replace: every leaf created and scheduled by the main thread
+static void BM_FlatLeafJobs(benchmark::State & state)
+{
+    ThreadPool threadPool(static_cast<size_t>(state.range(0)));
+    std::vector<float> input(elementCount, 2.f);
+    std::vector<float> output(elementCount);
+
+    for (auto _ : state) {
+        // leaves are batched under a few roots, one root cannot have more children than a queue can hold
+        for (size_t rootBegin = 0; rootBegin < elementCount; rootBegin += leafSize * (ThreadPool::maxJobCount / 2)) {
+            Job * root = threadPool.CreateJob([]() {});
+            const size_t rootEnd = std::min(elementCount, rootBegin + leafSize * (ThreadPool::maxJobCount / 2));
+            for (size_t begin = rootBegin; begin < rootEnd; begin += leafSize) {
+                threadPool.Schedule(threadPool.CreateJobAsChild(root, [&input, &output, begin]() { Process(input, output, begin, leafSize); }));
+            }
+            threadPool.Schedule(root);
+            threadPool.Wait(root);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elementCount));
+}
+
+static void SplitterWorkerCounts(benchmark::internal::Benchmark * benchmark)
+{
+    for (int numWorkers = 1; numWorkers <= MaxWorkers(); numWorkers *= 2) {
+        for (int splitter : { Count, DataSize, Auto }) { benchmark->Args({ splitter, numWorkers }); }
+    }
+}
+
+BENCHMARK(BM_ParallelFor)->ArgNames({ "splitter", "workers" })->Apply(SplitterWorkerCounts)->UseRealTime();
+BENCHMARK(BM_FlatLeafJobs)->ArgNames({ "workers" })->Apply(WorkerCounts)->UseRealTime();
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <ThreadPool/ThreadPool.h>
+
+#include "BenchUtils.h"
+
+using BenchUtils::Percentile;
+using JobSystem::Internal::Job;
+using JobSystem::Internal::Priority;
+using JobSystem::Internal::ThreadPool;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    void BusyWait(std::chrono::microseconds duration)
+    {
+        const auto end = Clock::now() + duration;
+        while (Clock::now() < end) {}
+    }
+
+    // A low priority job that keeps rescheduling itself until stopped, one chain keeps one worker saturated
+    struct BackgroundChain
+    {
+        ThreadPool * threadPool;
+        std::atomic<bool> * isStopped;
+        std::atomic<int> * numRunning;
+
+        void operator()() const
+        {
+            BusyWait(std::chrono::microseconds(20));
+            if (isStopped->load(std::memory_order_relaxed)) {
+                (*numRunning)--;
+                return;
+            }
+            threadPool->Schedule(threadPool->CreateJob(*this), Priority::Low);
+        }
+    };
+} // namespace
+
+// Latency from Schedule() to start of high priority jobs, with the pool idle or saturated with low priority chains.
+// The main thread never runs the high priority jobs itself, a worker has to pick them up.
+static void BM_HighPriorityLatency(benchmark::State & state)
+{
+    const bool isSaturated = state.range(0) != 0;
+    const auto numThreads = static_cast<size_t>(BenchUtils::MaxWorkers());
+    ThreadPool threadPool(numThreads);
+
+    std::atomic<bool> isStopped{ false };
+    std::atomic<int> numRunning{ 0 };
+    if (isSaturated) {
+        for (size_t i = 0; i < numThreads * 2; ++i) {
+            numRunning++;
+            threadPool.Schedule(threadPool.CreateJob(BackgroundChain{ &threadPool, &isStopped, &numRunning }), Priority::Low);
+        }
+    }
+
+    std::vector<double> latencies;
+    for (auto _ : state) {
+        std::atomic<int64_t> startedAt{ 0 };
+        Job * job = threadPool.CreateJob([&startedAt]() { startedAt.store(Clock::now().time_since_epoch().count(), std::memory_order_release); });
+
+        const int64_t scheduledAt = Clock::now().time_since_epoch().count();
+        threadPool.Schedule(job, Priority::High);
+        while (startedAt.load(std::memory_order_acquire) == 0) { std::this_thread::yield(); }
+
+        const double latency = std::chrono::duration<double>(Clock::duration(startedAt - scheduledAt)).count();
+        latencies.push_back(latency);
+        state.SetIterationTime(latency);
+
+        state.PauseTiming();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        state.ResumeTiming();
+    }
+
+    isStopped = true;
+    while (numRunning != 0) { std::this_thread::yield(); }
+
+    state.counters["p50_us"] = Percentile(latencies, 0.5) * 1e6;
+    state.counters["p99_us"] = Percentile(latencies, 0.99) * 1e6;
+}
+
+BENCHMARK(BM_HighPriorityLatency)->ArgNames({ "saturated" })->Arg(0)->Arg(1)->UseManualTime()->Iterations(500);
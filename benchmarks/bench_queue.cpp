@@ -0,0 +1,175 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+
+#include <ThreadPool/BoundedMpmcQueue.h>
+#include <ThreadPool/BoundedQueue.h>
+#include <ThreadPool/WorkStealingQueue.h>
+
+namespace
+{
+  constexpr size_t queueSize = 4096;
+  constexpr int batchSize = 64;
+
+  // Owner-only traffic: what a worker does with its own children in a fork-join workload
+  template<typename QueueType> void OwnerPushPop(benchmark::State & state)
+  {
+    QueueType queue(queueSize);
+    size_t value = 0;
+    for (auto _ : state) {
+      for (int i = 0; i < batchSize; ++i) { benchmark::DoNotOptimize(queue.Push(value)); }
+      for (int i = 0; i < batchSize; ++i) { benchmark::DoNotOptimize(queue.Pop(value)); }
+    }
+    state.SetItemsProcessed(state.iterations() * batchSize);
+  }
+
+  // Thread 0 owns the queue and pushes/pops, every other thread takes from the other end
+  template<typename QueueType> bool TakeFromOtherEnd(QueueType & queue, size_t & value) { return queue.Pop(value); }
+  template<> bool TakeFromOtherEnd(JobSystem::WorkStealingQueue<size_t> & queue, size_t & value) { return queue.Steal(value); }
+
+  template<typename QueueType> void OwnerWithThieves(benchmark::State & state)
+  {
+    static QueueType * queue = nullptr;
+    if (state.thread_index() == 0) queue = new QueueType(queueSize);
+
+    size_t value = 0;
+    size_t taken = 0;
+    for (auto _ : state) {
+      if (state.thread_index() == 0) {
+        for (int i = 0; i < batchSize; ++i) { queue->Push(value); }
+        for (int i = 0; i < batchSize / 2; ++i) { taken += queue->Pop(value) ? 1 : 0; }
+      } else {
+        taken += TakeFromOtherEnd(*queue, value) ? 1 : 0;
+      }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(taken));
+
+    if (state.thread_index() == 0) {
+      delete queue;
+      queue = nullptr;
+    }
+  }
+
+  enum ProducerMix
+  {
+    Balanced,    // every other thread produces
+    OneProducer, // thread 0 produces, the rest consume
+    OneConsumer, // thread 0 consumes, the rest produce
+  };
+
+  bool IsProducer(ProducerMix mix, int threadIndex)
+  {
+    switch (mix) {
+      case Balanced: return threadIndex % 2 == 0;
+      case OneProducer: return threadIndex == 0;
+      case OneConsumer: return threadIndex != 0;
+    }
+    return false;
+  }
+
+  // Shared queue, 1..N producers against 1..N consumers; only successful pushes and pops count as items
+  template<typename QueueType> void ProducersConsumers(benchmark::State & state)
+  {
+    static QueueType * queue = nullptr;
+    if (state.thread_index() == 0) queue = new QueueType(queueSize);
+
+    const bool isProducer = IsProducer(static_cast<ProducerMix>(state.range(0)), state.thread_index());
+    size_t value = 0;
+    size_t done = 0;
+    for (auto _ : state) {
+      for (int i = 0; i < batchSize; ++i) { done += (isProducer ? queue->Push(value) : queue->Pop(value)) ? 1 : 0; }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(done));
+
+    if (state.thread_index() == 0) {
+      delete queue;
+      queue = nullptr;
+    }
+  }
+} // namespace
+
+// Shared queue, 1..N producers against 1..N consumers; only successful pushes and pops count as items
+static void BM_BoundedMpmcQueue_ProducersConsumers(benchmark::State & state)
+{
+  static JobSystem::BoundedMpmcQueue<size_t> * queue = nullptr;
+  if (state.thread_index() == 0) queue = new JobSystem::BoundedMpmcQueue<size_t>(queueSize);
+
+  const bool isProducer = IsProducer(static_cast<ProducerMix>(state.range(0)), state.thread_index());
+  size_t value = 0;
+  size_t done = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < batchSize; ++i) { done += (isProducer ? queue->Push(value) : queue->Pop(value)) ? 1 : 0; }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(done));
+
+  if (state.thread_index() == 0) {
+    delete queue;
+    queue = nullptr;
+  }
+}
+
+// Same as above, but every thread moves `batchSize` items at once
+static void BM_BoundedMpmcQueue_ProducersConsumersBulk(benchmark::State & state)
+{
+  static JobSystem::BoundedMpmcQueue<size_t> * queue = nullptr;
+  if (state.thread_index() == 0) queue = new JobSystem::BoundedMpmcQueue<size_t>(queueSize);
+
+  const bool isProducer = IsProducer(static_cast<ProducerMix>(state.range(0)), state.thread_index());
+  size_t values[batchSize] = {};
+  size_t done = 0;
+  for (auto _ : state) { done += isProducer ? queue->PushBulk(values, batchSize) : queue->PopBulk(values, batchSize); }
+  state.SetItemsProcessed(static_cast<int64_t>(done));
+
+  if (state.thread_index() == 0) {
+    delete queue;
+    queue = nullptr;
+  }
+}
+
+static void BM_BoundedMpmcQueue_OwnerPushPop(benchmark::State & state) { OwnerPushPop<JobSystem::BoundedMpmcQueue<size_t>>(state); }
+static void BM_WorkStealingQueue_OwnerPushPop(benchmark::State & state) { OwnerPushPop<JobSystem::WorkStealingQueue<size_t>>(state); }
+
+static void BM_BoundedMpmcQueue_OwnerWithThieves(benchmark::State & state) { OwnerWithThieves<JobSystem::BoundedMpmcQueue<size_t>>(state); }
+static void BM_WorkStealingQueue_OwnerWithThieves(benchmark::State & state) { OwnerWithThieves<JobSystem::WorkStealingQueue<size_t>>(state); }
+
+BENCHMARK(BM_BoundedMpmcQueue_OwnerPushPop);
+BENCHMARK(BM_WorkStealingQueue_OwnerPushPop);
+
+BENCHMARK(BM_BoundedMpmcQueue_OwnerWithThieves)->ThreadRange(2, 8)->UseRealTime();
+BENCHMARK(BM_WorkStealingQueue_OwnerWithThieves)->ThreadRange(2, 8)->UseRealTime();
+
+BENCHMARK(BM_BoundedMpmcQueue_ProducersConsumers)->ArgNames({ "mix" })->Arg(Balanced)->Arg(OneProducer)->Arg(OneConsumer)->ThreadRange(2, 8)->UseRealTime();
+BENCHMARK(BM_BoundedMpmcQueue_ProducersConsumersBulk)->ArgNames({ "mix" })->Arg(Balanced)->Arg(OneProducer)->Arg(OneConsumer)->ThreadRange(2, 8)->UseRealTime();
+
+// The policy variants against the queue above, each with as many threads at either end as it allows.
+// One producer and one consumer run on every variant, `mix` picks which end of the two is thread 0.
+static void BM_QueueVariants_BoundedMpmcQueue(benchmark::State & state) { ProducersConsumers<JobSystem::BoundedMpmcQueue<size_t>>(state); }
+static void BM_QueueVariants_Spsc(benchmark::State & state) { ProducersConsumers<JobSystem::SpscQueue<size_t>>(state); }
+static void BM_QueueVariants_SpscStatic(benchmark::State & state) { ProducersConsumers<JobSystem::SpscQueue<size_t, queueSize>>(state); }
+static void BM_QueueVariants_Mpsc(benchmark::State & state) { ProducersConsumers<JobSystem::MpscQueue<size_t>>(state); }
+static void BM_QueueVariants_Spmc(benchmark::State & state) { ProducersConsumers<JobSystem::SpmcQueue<size_t>>(state); }
+static void BM_QueueVariants_Mpmc(benchmark::State & state) { ProducersConsumers<JobSystem::MpmcQueue<size_t>>(state); }
+static void BM_QueueVariants_MpmcStatic(benchmark::State & state) { ProducersConsumers<JobSystem::MpmcQueue<size_t, queueSize>>(state); }
+
+BENCHMARK(BM_QueueVariants_BoundedMpmcQueue)->ArgNames({ "mix" })->Arg(OneProducer)->Threads(2)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Spsc)->ArgNames({ "mix" })->Arg(OneProducer)->Threads(2)->UseRealTime();
+BENCHMARK(BM_QueueVariants_SpscStatic)->ArgNames({ "mix" })->Arg(OneProducer)->Threads(2)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Mpsc)->ArgNames({ "mix" })->Arg(OneProducer)->Threads(2)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Spmc)->ArgNames({ "mix" })->Arg(OneProducer)->Threads(2)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Mpmc)->ArgNames({ "mix" })->Arg(OneProducer)->Threads(2)->UseRealTime();
+BENCHMARK(BM_QueueVariants_MpmcStatic)->ArgNames({ "mix" })->Arg(OneProducer)->Threads(2)->UseRealTime();
+
+// many producers, one consumer: what an inbox sees
+BENCHMARK(BM_QueueVariants_BoundedMpmcQueue)->ArgNames({ "mix" })->Arg(OneConsumer)->ThreadRange(4, 8)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Mpsc)->ArgNames({ "mix" })->Arg(OneConsumer)->ThreadRange(4, 8)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Mpmc)->ArgNames({ "mix" })->Arg(OneConsumer)->ThreadRange(4, 8)->UseRealTime();
+
+// one producer, many consumers: what a distributing queue sees
+BENCHMARK(BM_QueueVariants_BoundedMpmcQueue)->ArgNames({ "mix" })->Arg(OneProducer)->ThreadRange(4, 8)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Spmc)->ArgNames({ "mix" })->Arg(OneProducer)->ThreadRange(4, 8)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Mpmc)->ArgNames({ "mix" })->Arg(OneProducer)->ThreadRange(4, 8)->UseRealTime();
+
+// many to many: the injection queue
+BENCHMARK(BM_QueueVariants_BoundedMpmcQueue)->ArgNames({ "mix" })->Arg(Balanced)->ThreadRange(4, 8)->UseRealTime();
+BENCHMARK(BM_QueueVariants_Mpmc)->ArgNames({ "mix" })->Arg(Balanced)->ThreadRange(4, 8)->UseRealTime();
+BENCHMARK(BM_QueueVariants_MpmcStatic)->ArgNames({ "mix" })->Arg(Balanced)->ThreadRange(4, 8)->UseRealTime();
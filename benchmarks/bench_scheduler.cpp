@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <ThreadPool/ThreadPool.h>
+
+#include "BenchUtils.h"
+
+using BenchUtils::FibData;
+using BenchUtils::FibJobFunction;
+using BenchUtils::Percentile;
+using BenchUtils::WorkerCounts;
+using JobSystem::Internal::Job;
+using JobSystem::Internal::ThreadPool;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    constexpr size_t jobsPerRoot = ThreadPool::maxJobCount / 2;
+} // namespace
+
+// Spawn and execute cost of jobs that do nothing: create, schedule, pick up, finish, release
+static void BM_EmptyJobs(benchmark::State & state)
+{
+    ThreadPool threadPool(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        Job * root = threadPool.CreateJob([]() {});
+        for (size_t i = 0; i < jobsPerRoot; ++i) { threadPool.Schedule(threadPool.CreateJobAsChild(root, []() {})); }
+        threadPool.Schedule(root);
+        threadPool.Wait(root);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * (jobsPerRoot + 1)));
+}
+
+// Same as above, the children go in through ScheduleBatch()
+static void BM_EmptyJobsBatch(benchmark::State & state)
+{
+    ThreadPool threadPool(static_cast<size_t>(state.range(0)));
+
+    std::vector<Job *> children(jobsPerRoot);
+    for (auto _ : state) {
+        Job * root = threadPool.CreateJob([]() {});
+        for (Job *& child : children) { child = threadPool.CreateJobAsChild(root, []() {}); }
+        threadPool.ScheduleBatch(children.data(), children.size());
+        threadPool.Schedule(root);
+        threadPool.Wait(root);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * (jobsPerRoot + 1)));
+}
+
+// Latency from Schedule() to the start of a job on an idle pool, the main thread never runs it itself
+static void BM_ScheduleToStart(benchmark::State & state)
+{
+    ThreadPool threadPool(static_cast<size_t>(state.range(0)));
+
+    std::vector<double> latencies;
+    for (auto _ : state) {
+        std::atomic<int64_t> startedAt{ 0 };
+        Job * job = threadPool.CreateJob([&startedAt]() { startedAt.store(Clock::now().time_since_epoch().count(), std::memory_order_release); });
+
+        const int64_t scheduledAt = Clock::now().time_since_epoch().count();
+        threadPool.Schedule(job);
+        while (startedAt.load(std::memory_order_acquire) == 0) { std::this_thread::yield(); }
+
+        const double latency = std::chrono::duration<double>(Clock::duration(startedAt - scheduledAt)).count();
+        latencies.push_back(latency);
+        state.SetIterationTime(latency);
+    }
+
+    state.counters["p50_us"] = Percentile(latencies, 0.5) * 1e6;
+    state.counters["p90_us"] = Percentile(latencies, 0.9) * 1e6;
+    state.counters["p99_us"] = Percentile(latencies, 0.99) * 1e6;
+    state.counters["p999_us"] = Percentile(latencies, 0.999) * 1e6;
+}
+
+// Recursive fork-join, every level waits for its two halves
+static void BM_ForkJoinScaling(benchmark::State & state)
+{
+    ThreadPool threadPool(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        FibData data = { &threadPool, 20, 0 };
+        Job * job = threadPool.CreateJob(&FibJobFunction, &data);
+        threadPool.Schedule(job);
+        threadPool.Wait(job);
+        benchmark::DoNotOptimize(data.result);
+    }
+}
+
+BENCHMARK(BM_EmptyJobs)->ArgNames({ "workers" })->Apply(WorkerCounts)->UseRealTime();
+BENCHMARK(BM_EmptyJobsBatch)->ArgNames({ "workers" })->Apply(WorkerCounts)->UseRealTime();
+BENCHMARK(BM_ScheduleToStart)->ArgNames({ "workers" })->Apply(WorkerCounts)->UseManualTime()->Iterations(2000);
+BENCHMARK(BM_ForkJoinScaling)->ArgNames({ "workers" })->Apply(WorkerCounts)->Unit(benchmark::kMillisecond)->UseRealTime();
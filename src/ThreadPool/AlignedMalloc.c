@@ -5,8 +5,9 @@
 #  include <stdlib.h>
 void * aligned_malloc(size_t size, size_t alignment)
 {
-  void * pointer;
-  posix_memalign(&pointer, alignment, size);
+  void * pointer = NULL;
+  // `pointer` is left untouched on failure
+  if (posix_memalign(&pointer, alignment, size) != 0) return NULL;
   return pointer;
 }
 
@@ -55,3 +56,88 @@ void aligned_free(void * pointer)
 void aligned_free(void * pointer) { free(((void **)pointer)[-1]); }
 
 #endif
+
+
+#if defined(__APPLE__) || defined(__linux__)
+
+#  include <stdint.h>
+#  include <sys/mman.h>
+
+static const size_t huge_page_size = (size_t)2 << 20;
+
+// huge page mappings are whole huge pages, so the tail of the last one is never shared with an other mapping
+static size_t page_size_of(size_t size, int huge_pages)
+{
+  return huge_pages == PAGE_ALLOC_SMALL ? size : (size + huge_page_size - 1) & ~(huge_page_size - 1);
+}
+
+void * page_alloc(size_t size, int huge_pages)
+{
+  const size_t mapped_size = page_size_of(size, huge_pages);
+  void * pointer = MAP_FAILED;
+#  if defined(MAP_HUGETLB)
+  if (huge_pages == PAGE_ALLOC_HUGE) pointer = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (pointer != MAP_FAILED) return pointer;
+#  endif
+  if (huge_pages == PAGE_ALLOC_SMALL) {
+    pointer = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return pointer == MAP_FAILED ? NULL : pointer;
+  }
+
+  // transparent huge pages only back huge page aligned ranges, so map one more and trim both ends
+  pointer = mmap(NULL, mapped_size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (pointer == MAP_FAILED) return NULL;
+  char * begin = (char *)pointer;
+  char * aligned = (char *)(((uintptr_t)begin + huge_page_size - 1) & ~(uintptr_t)(huge_page_size - 1));
+  const size_t head = (size_t)(aligned - begin);
+  if (head) munmap(begin, head);
+  if (head != huge_page_size) munmap(aligned + mapped_size, huge_page_size - head);
+#  if defined(MADV_HUGEPAGE)
+  madvise(aligned, mapped_size, MADV_HUGEPAGE);
+#  endif
+  return aligned;
+}
+
+void page_free(void * pointer, size_t size, int huge_pages)
+{
+  if (pointer) munmap(pointer, page_size_of(size, huge_pages));
+}
+
+#elif defined(_WIN32)
+
+#  include <windows.h>
+void * page_alloc(size_t size, int huge_pages)
+{
+  void * pointer = NULL;
+  // needs the "Lock pages in memory" privilege, large pages are committed right away
+  const size_t large_page_size = GetLargePageMinimum();
+  if (huge_pages == PAGE_ALLOC_HUGE && large_page_size) {
+    pointer = VirtualAlloc(NULL, (size + large_page_size - 1) & ~(large_page_size - 1), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+  }
+  if (!pointer) pointer = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  return pointer;
+}
+
+void page_free(void * pointer, size_t size, int huge_pages)
+{
+  (void)size;
+  (void)huge_pages;
+  if (pointer) VirtualFree(pointer, 0, MEM_RELEASE);
+}
+
+#else
+
+void * page_alloc(size_t size, int huge_pages)
+{
+  (void)huge_pages;
+  return aligned_malloc(size, 4096);
+}
+
+void page_free(void * pointer, size_t size, int huge_pages)
+{
+  (void)size;
+  (void)huge_pages;
+  aligned_free(pointer);
+}
+
+#endif
@@ -12,6 +12,17 @@ extern "C"
   void * aligned_malloc(size_t size, size_t alignment);
   void aligned_free(void * pointer);
 
+  // whole pages straight from the os, they only get committed on first touch
+  // huge pages: explicit ones need to be reserved (vm.nr_hugepages), without them it falls back to transparent ones
+  enum
+  {
+    PAGE_ALLOC_SMALL = 0,
+    PAGE_ALLOC_TRANSPARENT_HUGE = 1,
+    PAGE_ALLOC_HUGE = 2
+  };
+  void * page_alloc(size_t size, int huge_pages);
+  void page_free(void * pointer, size_t size, int huge_pages);
+
 
 #ifdef __cplusplus
 }
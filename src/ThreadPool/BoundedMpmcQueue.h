@@ -18,6 +18,10 @@ namespace JobSystem
     bool Push(T const & data);
     bool Pop(T & data);
 
+    // claim a contiguous range of up to `count` cells with a single CAS, return how many were pushed / popped
+    size_t PushBulk(T const * data, size_t count);
+    size_t PopBulk(T * data, size_t maxCount);
+
     bool IsEmpty() const noexcept;
 
     size_t Size() const noexcept;
@@ -96,6 +100,67 @@ namespace JobSystem
     return true;
   }
 
+  template<typename T> size_t BoundedMpmcQueue<T>::PushBulk(const T * data, size_t count)
+  {
+    if (count == 0) return 0;
+
+    size_t numClaimed = 0;
+    size_t pos = mBottom.load(std::memory_order_relaxed);
+    for (;;) {
+      // the cells are free for this lap up to the first one that is not, nobody else can take them without moving `mBottom`
+      numClaimed = 0;
+      intptr_t dif = 0;
+      while (numClaimed < count && numClaimed <= mBufferMask) {
+        const size_t seq = mBuffer[(pos + numClaimed) & mBufferMask].sequence.load(std::memory_order_acquire);
+        dif = (intptr_t)seq - (intptr_t)(pos + numClaimed);
+        if (dif != 0) break;
+        ++numClaimed;
+      }
+      if (numClaimed != 0) {
+        if (mBottom.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed)) break;
+      } else if (dif < 0)
+        return 0;
+      else
+        pos = mBottom.load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < numClaimed; ++i) {
+      Cell & cell = mBuffer[(pos + i) & mBufferMask];
+      cell.data = data[i];
+      cell.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return numClaimed;
+  }
+
+  template<typename T> size_t BoundedMpmcQueue<T>::PopBulk(T * data, size_t maxCount)
+  {
+    if (maxCount == 0) return 0;
+
+    size_t numClaimed = 0;
+    size_t pos = mTop.load(std::memory_order_relaxed);
+    for (;;) {
+      numClaimed = 0;
+      intptr_t dif = 0;
+      while (numClaimed < maxCount && numClaimed <= mBufferMask) {
+        const size_t seq = mBuffer[(pos + numClaimed) & mBufferMask].sequence.load(std::memory_order_acquire);
+        dif = (intptr_t)seq - (intptr_t)(pos + numClaimed + 1);
+        if (dif != 0) break;
+        ++numClaimed;
+      }
+      if (numClaimed != 0) {
+        if (mTop.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed)) break;
+      } else if (dif < 0)
+        return 0;
+      else
+        pos = mTop.load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < numClaimed; ++i) {
+      Cell & cell = mBuffer[(pos + i) & mBufferMask];
+      data[i] = cell.data;
+      cell.sequence.store(pos + i + mBufferMask + 1, std::memory_order_release);
+    }
+    return numClaimed;
+  }
+
   template<typename T> bool BoundedMpmcQueue<T>::IsEmpty() const noexcept
   {
     const size_t bottom = mBottom.load(std::memory_order_relaxed);
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace JobSystem
+{
+  // Who may call each end of a `BoundedQueue`
+  struct SingleProducer
+  {
+    static constexpr bool isShared = false;
+  };
+  struct MultipleProducers
+  {
+    static constexpr bool isShared = true;
+  };
+  struct SingleConsumer
+  {
+    static constexpr bool isShared = false;
+  };
+  struct MultipleConsumers
+  {
+    static constexpr bool isShared = true;
+  };
+
+  /**
+   * Bounded ring buffer whose algorithm is picked at compile time by who pushes and who pops
+   * A shared end claims its cells with a CAS and hands them over through per-cell sequence numbers (Vyukov), an end owned by a
+   * single thread claims them with a plain store. With a single thread at both ends there are no sequence numbers at all: each
+   * side keeps a copy of the other one's index and only reloads it when the ring looks full, or empty, so most calls never touch
+   * the other core's cache line. `capacity` may be given as a template constant, the cells are then part of the queue itself and
+   * the mask is a constant too; 0 takes it from the constructor instead and puts the cells on the heap. Keep the constant for
+   * small queues, the cells add up to the size of whatever holds the queue.
+   * The interface is the one of `BoundedMpmcQueue`.
+   */
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity = 0> class BoundedQueue
+  {
+  public:
+    static_assert(capacity != 1 && (capacity & (capacity - 1)) == 0, "The capacity has to be a power of two, at least 2");
+    static constexpr bool isSharedByProducers = ProducerPolicy::isShared;
+    static constexpr bool isSharedByConsumers = ConsumerPolicy::isShared;
+
+    // a constant capacity only
+    template<size_t size = capacity, typename = typename std::enable_if<size != 0>::type> BoundedQueue() : BoundedQueue(capacity)
+    {
+    }
+    explicit BoundedQueue(size_t bufferSize);
+    BoundedQueue(BoundedQueue const &) = delete;
+
+    void operator=(BoundedQueue const &) = delete;
+
+    bool Push(T const & data);
+    bool Pop(T & data);
+
+    // up to `count` cells at once, return how many were pushed / popped
+    size_t PushBulk(T const * data, size_t count);
+    size_t PopBulk(T * data, size_t maxCount);
+
+    bool IsEmpty() const noexcept;
+
+    size_t Size() const noexcept;
+
+    size_t Capacity() const noexcept { return Mask() + 1; }
+
+  private:
+    static constexpr bool hasSequences = ProducerPolicy::isShared || ConsumerPolicy::isShared;
+
+    struct SequencedCell
+    {
+      std::atomic<size_t> sequence;
+      T data = {};
+    };
+    struct PlainCell
+    {
+      T data = {};
+    };
+    typedef typename std::conditional<hasSequences, SequencedCell, PlainCell>::type Cell;
+
+    // inline with a constant capacity, which needs no mask stored either
+    struct NoMask
+    {
+    };
+    typedef typename std::conditional<capacity != 0, Cell[capacity ? capacity : 1], std::unique_ptr<Cell[]>>::type Buffer;
+    typedef typename std::conditional<capacity != 0, NoMask, size_t>::type BufferMask;
+
+    size_t Mask() const noexcept
+    {
+      if constexpr (capacity != 0) {
+        return capacity - 1;
+      } else {
+        return mBufferMask;
+      }
+    }
+
+    // how many cells from `pos` on are free to push into, at most `count`; fails if the first one is not
+    size_t ClaimForPush(size_t pos, size_t count, intptr_t & dif) const;
+    size_t ClaimForPop(size_t pos, size_t count, intptr_t & dif) const;
+
+    // Same layout rules as `BoundedMpmcQueue`: keep each end on a cache line of its own
+    static size_t const cachelineSize = 64;
+    typedef char CachelinePadType[cachelineSize];
+
+    CachelinePadType pad0_{};
+    Buffer mBuffer;
+    BufferMask mBufferMask{};
+    volatile CachelinePadType pad1_{};
+    // producer end; `mCachedTop` is the producer's copy of `mTop`, single producer single consumer only
+    std::atomic<size_t> mBottom{};
+    size_t mCachedTop = 0;
+    volatile CachelinePadType pad2_{};
+    // consumer end
+    std::atomic<size_t> mTop{};
+    size_t mCachedBottom = 0;
+    volatile CachelinePadType pad3_{};
+  };
+
+  template<typename T, size_t capacity = 0> using SpscQueue = BoundedQueue<T, SingleProducer, SingleConsumer, capacity>;
+  template<typename T, size_t capacity = 0> using MpscQueue = BoundedQueue<T, MultipleProducers, SingleConsumer, capacity>;
+  template<typename T, size_t capacity = 0> using SpmcQueue = BoundedQueue<T, SingleProducer, MultipleConsumers, capacity>;
+  template<typename T, size_t capacity = 0> using MpmcQueue = BoundedQueue<T, MultipleProducers, MultipleConsumers, capacity>;
+
+  // ------------------------------------------------------------------------------------------------------------------
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::BoundedQueue(size_t bufferSize)
+  {
+    assert((bufferSize >= 2) && ((bufferSize & (bufferSize - 1)) == 0));
+    if constexpr (capacity != 0) {
+      assert(bufferSize == capacity);
+    } else {
+      mBuffer.reset(new Cell[bufferSize]);
+      mBufferMask = bufferSize - 1;
+    }
+    if constexpr (hasSequences) {
+      for (size_t i = 0; i != bufferSize; i += 1) { mBuffer[i].sequence.store(i, std::memory_order_relaxed); }
+    }
+  }
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  size_t BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::ClaimForPush(size_t pos, size_t count, intptr_t & dif) const
+  {
+    // the cells are free for this lap up to the first one that is not
+    size_t numClaimed = 0;
+    dif = 0;
+    while (numClaimed < count && numClaimed <= Mask()) {
+      const size_t seq = mBuffer[(pos + numClaimed) & Mask()].sequence.load(std::memory_order_acquire);
+      dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + numClaimed);
+      if (dif != 0) break;
+      ++numClaimed;
+    }
+    return numClaimed;
+  }
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  size_t BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::ClaimForPop(size_t pos, size_t count, intptr_t & dif) const
+  {
+    size_t numClaimed = 0;
+    dif = 0;
+    while (numClaimed < count && numClaimed <= Mask()) {
+      const size_t seq = mBuffer[(pos + numClaimed) & Mask()].sequence.load(std::memory_order_acquire);
+      dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + numClaimed + 1);
+      if (dif != 0) break;
+      ++numClaimed;
+    }
+    return numClaimed;
+  }
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  bool BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::Push(const T & data)
+  {
+    return PushBulk(&data, 1) == 1;
+  }
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  bool BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::Pop(T & data)
+  {
+    return PopBulk(&data, 1) == 1;
+  }
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  size_t BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::PushBulk(const T * data, size_t count)
+  {
+    if (count == 0) return 0;
+    size_t pos = mBottom.load(std::memory_order_relaxed);
+
+    if constexpr (!hasSequences) {
+      // only look at the consumer's index once our copy of it says the ring is full
+      if (pos - mCachedTop + count > Capacity()) mCachedTop = mTop.load(std::memory_order_acquire);
+      const size_t numPushed = std::min(count, Capacity() - (pos - mCachedTop));
+      for (size_t i = 0; i < numPushed; ++i) mBuffer[(pos + i) & Mask()].data = data[i];
+      mBottom.store(pos + numPushed, std::memory_order_release);
+      return numPushed;
+    } else {
+      size_t numClaimed = 0;
+      intptr_t dif = 0;
+      if constexpr (ProducerPolicy::isShared) {
+        for (;;) {
+          // nobody else can take the claimed cells without moving `mBottom`
+          numClaimed = ClaimForPush(pos, count, dif);
+          if (numClaimed != 0) {
+            if (mBottom.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed)) break;
+          } else if (dif < 0)
+            return 0;
+          else
+            pos = mBottom.load(std::memory_order_relaxed);
+        }
+      } else {
+        // the cells can only be taken by us
+        numClaimed = ClaimForPush(pos, count, dif);
+        if (numClaimed == 0) return 0;
+        mBottom.store(pos + numClaimed, std::memory_order_relaxed);
+      }
+      for (size_t i = 0; i < numClaimed; ++i) {
+        Cell & cell = mBuffer[(pos + i) & Mask()];
+        cell.data = data[i];
+        cell.sequence.store(pos + i + 1, std::memory_order_release);
+      }
+      return numClaimed;
+    }
+  }
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  size_t BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::PopBulk(T * data, size_t maxCount)
+  {
+    if (maxCount == 0) return 0;
+    size_t pos = mTop.load(std::memory_order_relaxed);
+
+    if constexpr (!hasSequences) {
+      // only look at the producer's index once our copy of it says the ring is empty
+      if (mCachedBottom - pos < maxCount) mCachedBottom = mBottom.load(std::memory_order_acquire);
+      const size_t numPopped = std::min(maxCount, mCachedBottom - pos);
+      for (size_t i = 0; i < numPopped; ++i) data[i] = mBuffer[(pos + i) & Mask()].data;
+      mTop.store(pos + numPopped, std::memory_order_release);
+      return numPopped;
+    } else {
+      size_t numClaimed = 0;
+      intptr_t dif = 0;
+      if constexpr (ConsumerPolicy::isShared) {
+        for (;;) {
+          numClaimed = ClaimForPop(pos, maxCount, dif);
+          if (numClaimed != 0) {
+            if (mTop.compare_exchange_weak(pos, pos + numClaimed, std::memory_order_relaxed)) break;
+          } else if (dif < 0)
+            return 0;
+          else
+            pos = mTop.load(std::memory_order_relaxed);
+        }
+      } else {
+        numClaimed = ClaimForPop(pos, maxCount, dif);
+        if (numClaimed == 0) return 0;
+        mTop.store(pos + numClaimed, std::memory_order_relaxed);
+      }
+      for (size_t i = 0; i < numClaimed; ++i) {
+        Cell & cell = mBuffer[(pos + i) & Mask()];
+        data[i] = cell.data;
+        cell.sequence.store(pos + i + Mask() + 1, std::memory_order_release);
+      }
+      return numClaimed;
+    }
+  }
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  bool BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::IsEmpty() const noexcept
+  {
+    const size_t bottom = mBottom.load(std::memory_order_relaxed);
+    const size_t top = mTop.load(std::memory_order_relaxed);
+    return bottom <= top;
+  }
+
+  template<typename T, typename ProducerPolicy, typename ConsumerPolicy, size_t capacity>
+  size_t BoundedQueue<T, ProducerPolicy, ConsumerPolicy, capacity>::Size() const noexcept
+  {
+    const size_t bottom = mBottom.load(std::memory_order_relaxed);
+    const size_t top = mTop.load(std::memory_order_relaxed);
+    return bottom >= top ? bottom - top : 0;
+  }
+
+} // namespace JobSystem
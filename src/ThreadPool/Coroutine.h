@@ -0,0 +1,235 @@
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "Coroutine.h needs C++20, configure with ENABLE_COROUTINES=ON"
+#endif
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace JobSystem
+{
+    template<typename ResultType = void> class Task;
+
+    namespace Internal
+    {
+        struct TaskPromiseBase
+        {
+            std::coroutine_handle<> continuation;
+            // set for the outermost task only, see `SyncWait()`
+            std::atomic<bool> * isDone = nullptr;
+
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template<typename PromiseType> std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> handle) noexcept
+                {
+                    TaskPromiseBase & promise = handle.promise();
+                    if (promise.continuation) { return promise.continuation; }
+                    // the frame is suspended already, the waiter may destroy it right after this store
+                    if (promise.isDone) { promise.isDone->store(true, std::memory_order_release); }
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            // same as jobs: exceptions are not propagated
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+
+        template<typename ResultType> struct TaskPromise : TaskPromiseBase
+        {
+            std::optional<ResultType> value;
+
+            Task<ResultType> get_return_object() noexcept;
+
+            template<typename ValueType> void return_value(ValueType && result) { value.emplace(std::forward<ValueType>(result)); }
+            ResultType TakeValue() { return std::move(*value); }
+        };
+
+        template<> struct TaskPromise<void> : TaskPromiseBase
+        {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() const noexcept {}
+            void TakeValue() const noexcept {}
+        };
+
+        /**
+         * Suspends the coroutine until the given jobs, and all of their children, have finished
+         * The jobs get scheduled by the awaiter. The coroutine is resumed by a continuation on whichever worker finishes the last one,
+         * so nothing waits on a worker stack in the meantime.
+         */
+        class JobAwaiter
+        {
+        public:
+            JobAwaiter(ThreadPool & threadPool, Job * job) : mThreadPool(threadPool), mJobs(1, job) {}
+            JobAwaiter(ThreadPool & threadPool, std::vector<Job *> jobs) : mThreadPool(threadPool), mJobs(std::move(jobs)) {}
+
+            JobAwaiter(const JobAwaiter &) = delete;
+            JobAwaiter & operator=(const JobAwaiter &) = delete;
+
+            bool await_ready() const noexcept { return mJobs.empty(); }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                mHandle = handle;
+                mRemaining.store(mJobs.size(), std::memory_order_relaxed);
+
+                // the coroutine may resume and destroy this awaiter as soon as the last job got scheduled, use locals only
+                ThreadPool & threadPool = mThreadPool;
+                Job * const * jobs = mJobs.data();
+                const size_t count = mJobs.size();
+                for (size_t i = 0; i != count; ++i) {
+                    Job * continuation = threadPool.CreateJob([this]() {
+                        if (mRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) { mHandle.resume(); }
+                    });
+                    threadPool.AddContinuation(jobs[i], continuation);
+                    threadPool.Schedule(jobs[i]);
+                }
+            }
+
+            void await_resume() const noexcept {}
+
+        private:
+            ThreadPool & mThreadPool;
+            std::vector<Job *> mJobs;
+            std::atomic<size_t> mRemaining{ 0 };
+            std::coroutine_handle<> mHandle;
+        };
+
+        /**
+         * Suspends the coroutine and resumes it from a job on the pool
+         */
+        class ScheduleAwaiter
+        {
+        public:
+            ScheduleAwaiter(ThreadPool & threadPool, Priority priority) : mThreadPool(threadPool), mPriority(priority) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                Job * job = mThreadPool.CreateJob([handle]() { handle.resume(); });
+                mThreadPool.Schedule(job, mPriority);
+            }
+
+            void await_resume() const noexcept {}
+
+        private:
+            ThreadPool & mThreadPool;
+            Priority mPriority;
+        };
+    } // namespace Internal
+
+    /**
+     * Lazily started coroutine, it runs when it gets awaited or passed to `SyncWait()`
+     * Awaiting a task resumes the awaiting coroutine on the thread that completes it.
+     */
+    template<typename ResultType> class Task
+    {
+    public:
+        typedef Internal::TaskPromise<ResultType> promise_type;
+        typedef std::coroutine_handle<promise_type> HandleType;
+
+        Task() = default;
+        explicit Task(HandleType handle) : mHandle(handle) {}
+        ~Task()
+        {
+            if (mHandle) { mHandle.destroy(); }
+        }
+
+        Task(const Task &) = delete;
+        Task & operator=(const Task &) = delete;
+        Task(Task && other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) {}
+        Task & operator=(Task && other) noexcept
+        {
+            if (this != &other) {
+                if (mHandle) { mHandle.destroy(); }
+                mHandle = std::exchange(other.mHandle, nullptr);
+            }
+            return *this;
+        }
+
+        bool IsValid() const { return static_cast<bool>(mHandle); }
+
+        class Awaiter
+        {
+        public:
+            explicit Awaiter(HandleType handle) : mHandle(handle) {}
+
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                mHandle.promise().continuation = awaiting;
+                return mHandle;
+            }
+            ResultType await_resume() { return mHandle.promise().TakeValue(); }
+
+        private:
+            HandleType mHandle;
+        };
+
+        Awaiter operator co_await() && noexcept
+        {
+            assert(mHandle);
+            return Awaiter(mHandle);
+        }
+
+    private:
+        template<typename T> friend T SyncWait(Internal::ThreadPool & threadPool, Task<T> task);
+
+        HandleType mHandle;
+    };
+
+    namespace Internal
+    {
+        template<typename ResultType> Task<ResultType> TaskPromise<ResultType>::get_return_object() noexcept
+        {
+            return Task<ResultType>(std::coroutine_handle<TaskPromise<ResultType>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept { return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this)); }
+    } // namespace Internal
+
+    /**
+     * `co_await WhenDone(pool, job)` schedules `job` and resumes once it and all of its children have finished
+     * `job` must be created but not scheduled.
+     */
+    inline Internal::JobAwaiter WhenDone(Internal::ThreadPool & threadPool, Internal::Job * job) { return Internal::JobAwaiter(threadPool, job); }
+
+    // same for a group of unscheduled jobs, resumes once the last one has finished
+    inline Internal::JobAwaiter WhenAll(Internal::ThreadPool & threadPool, std::vector<Internal::Job *> jobs) { return Internal::JobAwaiter(threadPool, std::move(jobs)); }
+
+    // `co_await SwitchTo(pool)` continues the coroutine as a job on the pool
+    inline Internal::ScheduleAwaiter SwitchTo(Internal::ThreadPool & threadPool, Internal::Priority priority = Internal::Priority::Normal)
+    {
+        return Internal::ScheduleAwaiter(threadPool, priority);
+    }
+
+    /**
+     * Runs `task` on the calling thread until its first suspension, then executes other jobs until it has completed
+     */
+    template<typename ResultType> ResultType SyncWait(Internal::ThreadPool & threadPool, Task<ResultType> task)
+    {
+        assert(task.mHandle);
+        std::atomic<bool> isDone{ false };
+        task.mHandle.promise().isDone = &isDone;
+        task.mHandle.resume();
+        threadPool.WaitFor([&isDone]() { return isDone.load(std::memory_order_acquire); });
+        return task.mHandle.promise().TakeValue();
+    }
+
+} // namespace JobSystem
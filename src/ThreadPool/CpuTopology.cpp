@@ -0,0 +1,218 @@
+#include "CpuTopology.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#if defined(__linux__)
+#    include <pthread.h>
+#    include <sched.h>
+#    include <dirent.h>
+#endif
+
+using namespace JobSystem;
+
+namespace
+{
+#if defined(__linux__)
+    const std::string sysfsCpuPath = "/sys/devices/system/cpu/";
+    const std::string sysfsNodePath = "/sys/devices/system/node/";
+
+    // first line of a sysfs file, empty if it does not exist
+    std::string ReadLine(const std::string & path)
+    {
+        std::ifstream file(path);
+        std::string line;
+        if (file) std::getline(file, line);
+        return line;
+    }
+
+    // the whole of `text` has to be a decimal number that fits, `value` is left as is otherwise
+    bool ParseNumber(const std::string & text, uint32_t & value)
+    {
+        const char * end = text.data() + text.size();
+        uint32_t number = 0;
+        const auto result = std::from_chars(text.data(), end, number);
+        if (result.ec != std::errc() || result.ptr != end) return false;
+        value = number;
+        return true;
+    }
+
+    bool ReadNumber(const std::string & path, uint32_t & value) { return ParseNumber(ReadLine(path), value); }
+
+    // lowest cpu sharing the highest level cache, the package if there is no cache information
+    uint32_t FindCacheGroup(uint32_t cpu, uint32_t package)
+    {
+        uint32_t bestLevel = 0;
+        uint32_t group = package;
+        for (uint32_t index = 0;; ++index) {
+            const std::string cachePath = sysfsCpuPath + "cpu" + std::to_string(cpu) + "/cache/index" + std::to_string(index) + "/";
+            uint32_t level = 0;
+            if (!ReadNumber(cachePath + "level", level)) break;
+            if (level <= bestLevel) continue;
+
+            const std::vector<uint32_t> sharedCpus = CpuTopology::ParseCpuList(ReadLine(cachePath + "shared_cpu_list"));
+            if (sharedCpus.empty()) continue;
+            bestLevel = level;
+            group = *std::min_element(sharedCpus.begin(), sharedCpus.end());
+        }
+        return group;
+    }
+
+    std::map<uint32_t, uint32_t> ReadNodes()
+    {
+        std::map<uint32_t, uint32_t> nodeOfCpu;
+        DIR * directory = opendir(sysfsNodePath.c_str());
+        if (!directory) return nodeOfCpu;
+
+        while (dirent * entry = readdir(directory)) {
+            const std::string name = entry->d_name;
+            uint32_t node = 0;
+            if (name.size() <= 4 || name.compare(0, 4, "node") != 0 || !ParseNumber(name.substr(4), node)) continue;
+
+            for (const uint32_t cpu : CpuTopology::ParseCpuList(ReadLine(sysfsNodePath + name + "/cpulist"))) { nodeOfCpu[cpu] = node; }
+        }
+        closedir(directory);
+        return nodeOfCpu;
+    }
+#endif
+} // namespace
+
+CpuTopology CpuTopology::Discover()
+{
+#if defined(__linux__)
+    std::vector<uint32_t> cpus = ParseCpuList(ReadLine(sysfsCpuPath + "online"));
+
+    // only what our affinity mask allows, a taskset or cgroup restricted process must not pin outside of it
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&allowed](uint32_t cpu) { return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed); }), cpus.end());
+    }
+    if (cpus.empty()) return Flat(std::thread::hardware_concurrency());
+
+    const std::map<uint32_t, uint32_t> nodeOfCpu = ReadNodes();
+
+    CpuTopology topology;
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> coreIndices;
+    std::map<uint32_t, uint32_t> threadsOfCore;
+    for (const uint32_t cpu : cpus) {
+        const std::string topologyPath = sysfsCpuPath + "cpu" + std::to_string(cpu) + "/topology/";
+        uint32_t package = 0;
+        uint32_t coreId = cpu;
+        ReadNumber(topologyPath + "physical_package_id", package);
+        ReadNumber(topologyPath + "core_id", coreId);
+
+        // core ids are only unique within their package
+        const auto coreIndex = coreIndices.emplace(std::make_pair(package, coreId), static_cast<uint32_t>(coreIndices.size())).first->second;
+        const auto node = nodeOfCpu.find(cpu);
+
+        CpuInfo info;
+        info.id = cpu;
+        info.core = coreIndex;
+        info.thread = threadsOfCore[coreIndex]++;
+        info.package = package;
+        info.cache = FindCacheGroup(cpu, package);
+        info.node = node != nodeOfCpu.end() ? node->second : 0;
+        topology.mCpus.push_back(info);
+    }
+    return topology;
+#else
+    return Flat(std::thread::hardware_concurrency());
+#endif
+}
+
+CpuTopology CpuTopology::Flat(size_t numCpus)
+{
+    CpuTopology topology;
+    for (size_t i = 0; i < std::max<size_t>(numCpus, 1); ++i) {
+        const auto cpu = static_cast<uint32_t>(i);
+        topology.mCpus.push_back({ cpu, cpu, 0, 0, 0, 0 });
+    }
+    return topology;
+}
+
+CpuDistance CpuTopology::Distance(size_t first, size_t second) const
+{
+    const CpuInfo & a = mCpus[first];
+    const CpuInfo & b = mCpus[second];
+    if (a.id == b.id) return CpuDistance::Same;
+    if (a.core == b.core) return CpuDistance::SmtSibling;
+    if (a.package == b.package && a.cache == b.cache) return CpuDistance::SharedCache;
+    if (a.node == b.node) return CpuDistance::SameNode;
+    return CpuDistance::Remote;
+}
+
+std::vector<size_t> CpuTopology::PlacementOrder() const
+{
+    std::vector<size_t> order(mCpus.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t first, size_t second) {
+        const CpuInfo & a = mCpus[first];
+        const CpuInfo & b = mCpus[second];
+        return std::tie(a.thread, a.node, a.package, a.cache, a.core, a.id) < std::tie(b.thread, b.node, b.package, b.cache, b.core, b.id);
+    });
+    return order;
+}
+
+namespace
+{
+    // far beyond any kernel's cpu count, keeps a garbled list from producing billions of cpus
+    const uint32_t maxCpuNumber = 1u << 16;
+
+    // a non-empty string of digits, false for anything else
+    bool ParseCpuNumber(const std::string & text, uint32_t & cpu)
+    {
+        if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) return false;
+        uint32_t value = 0;
+        for (const char digit : text) {
+            value = value * 10 + static_cast<uint32_t>(digit - '0');
+            if (value > maxCpuNumber) return false;
+        }
+        cpu = value;
+        return true;
+    }
+} // namespace
+
+std::vector<uint32_t> CpuTopology::ParseCpuList(const std::string & list)
+{
+    std::vector<uint32_t> cpus;
+    size_t position = 0;
+    while (position < list.size()) {
+        size_t end = list.find(',', position);
+        if (end == std::string::npos) end = list.size();
+
+        // entries that are not a number or a range of two are skipped
+        std::string range = list.substr(position, end - position);
+        range.erase(0, range.find_first_not_of("\n "));
+        range.erase(range.find_last_not_of("\n ") + 1);
+        const size_t dash = range.find('-');
+        uint32_t first = 0;
+        uint32_t last = 0;
+        const bool isValid = dash == std::string::npos ? ParseCpuNumber(range, first) && ParseCpuNumber(range, last)
+                                                       : ParseCpuNumber(range.substr(0, dash), first) && ParseCpuNumber(range.substr(dash + 1), last);
+        if (isValid) {
+            for (uint32_t cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        position = end + 1;
+    }
+    return cpus;
+}
+
+bool CpuTopology::PinCurrentThread(uint32_t cpu)
+{
+#if defined(__linux__)
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace JobSystem
+{
+    /**
+     * How close two logical cpus are, in the order stealing should prefer them
+     */
+    enum class CpuDistance : uint8_t
+    {
+        Same = 0,
+        SmtSibling,  // same physical core
+        SharedCache, // same last level cache
+        SameNode,    // same NUMA node
+        Remote
+    };
+    constexpr size_t cpuDistanceCount = 5;
+
+    struct CpuInfo
+    {
+        uint32_t id;      // logical cpu number as the OS knows it
+        uint32_t core;    // physical core, unique across packages
+        uint32_t thread;  // 0 for the first hardware thread of its core, 1 for its SMT sibling, ...
+        uint32_t package; // socket
+        uint32_t cache;   // lowest cpu id sharing the last level cache
+        uint32_t node;    // NUMA node
+    };
+
+    /**
+     * Logical cpus the process may run on, with their SMT, cache and NUMA relationships
+     * Read from sysfs on Linux; elsewhere every cpu counts as its own core on a single node.
+     */
+    class CpuTopology
+    {
+    public:
+        static CpuTopology Discover();
+        // `hardware_concurrency()` cpus without any relationship
+        static CpuTopology Flat(size_t numCpus);
+
+        const std::vector<CpuInfo> & Cpus() const { return mCpus; }
+        size_t NumCpus() const { return mCpus.size(); }
+
+        // takes indices into `Cpus()`
+        CpuDistance Distance(size_t first, size_t second) const;
+
+        /**
+         * Indices into `Cpus()` in the order workers should be placed on them
+         * One thread per physical core first, grouped by node and cache, SMT siblings only after every core got one.
+         */
+        std::vector<size_t> PlacementOrder() const;
+
+        // parses the sysfs list format, "0-3,8,10-11"
+        static std::vector<uint32_t> ParseCpuList(const std::string & list);
+
+        // false if pinning is not supported or the cpu is not available
+        static bool PinCurrentThread(uint32_t cpu);
+
+    private:
+        std::vector<CpuInfo> mCpus;
+    };
+
+} // namespace JobSystem
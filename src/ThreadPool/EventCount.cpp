@@ -0,0 +1,94 @@
+#include "EventCount.h"
+
+#include <algorithm>
+#include <climits>
+
+#if defined(__linux__)
+#    include <ctime>
+#else
+#    include <chrono>
+#endif
+
+#if defined(__linux__)
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+using namespace JobSystem;
+
+uint32_t EventCount::PrepareWait() noexcept
+{
+    mWaiters.fetch_add(1, std::memory_order_seq_cst);
+    // pairs with the fence in Notify(): either they see us waiting, or we see their work when re-checking
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return mEpoch.load(std::memory_order_acquire);
+}
+
+void EventCount::CancelWait() noexcept { mWaiters.fetch_sub(1, std::memory_order_relaxed); }
+
+void EventCount::CommitWait(uint32_t epoch) noexcept
+{
+#if defined(__linux__)
+    // returns immediately if the epoch has moved since PrepareWait(), spurious wake-ups are fine
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&mEpoch), FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+#else
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this, epoch]() { return mEpoch.load(std::memory_order_acquire) != epoch; });
+    }
+#endif
+    mWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::CommitWait(uint32_t epoch, int64_t timeoutNanoseconds) noexcept
+{
+#if defined(__linux__)
+    // FUTEX_WAIT takes a relative timeout
+    timespec timeout;
+    timeout.tv_sec = timeoutNanoseconds / 1000000000;
+    timeout.tv_nsec = timeoutNanoseconds % 1000000000;
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&mEpoch), FUTEX_WAIT_PRIVATE, epoch, &timeout, nullptr, 0);
+#else
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait_for(lock, std::chrono::nanoseconds(timeoutNanoseconds), [this, epoch]() { return mEpoch.load(std::memory_order_acquire) != epoch; });
+    }
+#endif
+    mWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::Notify(uint32_t count) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // nobody beyond the current waiters can take a wake-up, a batch of jobs should not turn into as many of them
+    const uint32_t numWaiters = mWaiters.load(std::memory_order_relaxed);
+    if (count == 0 || numWaiters == 0) return;
+    Wake(std::min(count, numWaiters));
+}
+
+void EventCount::NotifyAll() noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Wake(UINT32_MAX);
+}
+
+void EventCount::Wake(uint32_t count) noexcept
+{
+#if defined(__linux__)
+    mEpoch.fetch_add(1, std::memory_order_release);
+    const int numToWake = count > static_cast<uint32_t>(INT_MAX) ? INT_MAX : static_cast<int>(count);
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&mEpoch), FUTEX_WAKE_PRIVATE, numToWake, nullptr, nullptr, 0);
+#else
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEpoch.fetch_add(1, std::memory_order_release);
+    }
+    if (count == UINT32_MAX) {
+        mCondition.notify_all();
+    } else {
+        const uint32_t numToWake = std::min(count, mWaiters.load(std::memory_order_relaxed));
+        for (uint32_t i = 0; i < numToWake; ++i) { mCondition.notify_one(); }
+    }
+#endif
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+#if !defined(__linux__)
+#    include <mutex>
+#    include <condition_variable>
+#endif
+
+namespace JobSystem
+{
+    /**
+     * Eventcount to park idle threads without losing wake-ups
+     * Waiter: `PrepareWait()`, re-check the condition, then `CancelWait()` or `CommitWait()`
+     * Notifier: publish the work, then `Notify()`, which is only a fence and a load when nobody sleeps
+     * Uses futex on Linux, mutex + condition variable elsewhere
+     */
+    class EventCount
+    {
+    public:
+        EventCount() = default;
+        EventCount(const EventCount &) = delete;
+        EventCount & operator=(const EventCount &) = delete;
+
+        uint32_t PrepareWait() noexcept;
+        void CancelWait() noexcept;
+        void CommitWait(uint32_t epoch) noexcept;
+        // gives up after `timeoutNanoseconds` at the latest, the caller re-checks either way
+        void CommitWait(uint32_t epoch, int64_t timeoutNanoseconds) noexcept;
+
+        void Notify(uint32_t count) noexcept;
+        void NotifyAll() noexcept;
+
+        uint32_t NumWaiters() const noexcept { return mWaiters.load(std::memory_order_relaxed); }
+
+    private:
+        void Wake(uint32_t count) noexcept;
+
+        std::atomic<uint32_t> mEpoch{ 0 };
+        std::atomic<uint32_t> mWaiters{ 0 };
+
+#if !defined(__linux__)
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+#endif
+    };
+
+} // namespace JobSystem
@@ -0,0 +1,114 @@
+#include "Fiber.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+#if JOBSYSTEM_HAS_FIBERS
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+using namespace JobSystem;
+
+#if JOBSYSTEM_HAS_FIBERS
+
+extern "C" void JobSystemSwitchFiber(void ** saveStackPointer, void * loadStackPointer);
+extern "C" void JobSystemFiberTrampoline();
+
+// System V x86-64: push the callee-saved registers and the control words, swap stacks, pop them for the other side.
+// A new fiber "returns" into the trampoline, which calls the entry function kept in r12 with the argument kept in r13.
+__asm__(".text\n"
+        ".globl JobSystemSwitchFiber\n"
+        ".hidden JobSystemSwitchFiber\n"
+        ".type JobSystemSwitchFiber, @function\n"
+        ".p2align 4\n"
+        "JobSystemSwitchFiber:\n"
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    subq $8, %rsp\n"
+        "    stmxcsr (%rsp)\n"
+        "    fnstcw 4(%rsp)\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq %rsi, %rsp\n"
+        "    ldmxcsr (%rsp)\n"
+        "    fldcw 4(%rsp)\n"
+        "    addq $8, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n"
+        ".size JobSystemSwitchFiber, .-JobSystemSwitchFiber\n"
+        ".globl JobSystemFiberTrampoline\n"
+        ".hidden JobSystemFiberTrampoline\n"
+        ".type JobSystemFiberTrampoline, @function\n"
+        ".p2align 4\n"
+        "JobSystemFiberTrampoline:\n"
+        "    movq %r13, %rdi\n"
+        "    callq *%r12\n"
+        "    ud2\n"
+        ".size JobSystemFiberTrampoline, .-JobSystemFiberTrampoline\n");
+
+namespace
+{
+    // default MXCSR (all exceptions masked, round to nearest) and x87 control word
+    const uint64_t initialControlWords = 0x1F80u | (uint64_t{ 0x037Fu } << 32);
+} // namespace
+
+Fiber::Fiber(size_t stackSize, EntryFunction entry, void * argument)
+{
+    const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    mStackSize = (stackSize + pageSize - 1) & ~(pageSize - 1);
+
+    // one extra page at the low end as guard, the stack grows down into it
+    mStack = mmap(nullptr, mStackSize + pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (mStack == MAP_FAILED) {
+        mStack = nullptr;
+        std::abort();
+    }
+    mprotect(mStack, pageSize, PROT_NONE);
+
+    // the slots JobSystemSwitchFiber() pops, the trampoline is entered with a 16 byte aligned stack
+    const uintptr_t stackTop = (reinterpret_cast<uintptr_t>(mStack) + pageSize + mStackSize - 16) & ~uintptr_t{ 15 };
+    uint64_t * slots = reinterpret_cast<uint64_t *>(stackTop);
+    slots[-1] = reinterpret_cast<uintptr_t>(&JobSystemFiberTrampoline); // return address
+    slots[-2] = 0;                                                      // rbp
+    slots[-3] = 0;                                                      // rbx
+    slots[-4] = reinterpret_cast<uintptr_t>(entry);                     // r12
+    slots[-5] = reinterpret_cast<uintptr_t>(argument);                  // r13
+    slots[-6] = 0;                                                      // r14
+    slots[-7] = 0;                                                      // r15
+    slots[-8] = initialControlWords;
+    mStackPointer = &slots[-8];
+}
+
+Fiber::~Fiber()
+{
+    if (mStack) {
+        const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        munmap(mStack, mStackSize + pageSize);
+    }
+}
+
+void Fiber::SwitchTo(Fiber & next) noexcept
+{
+    assert(&next != this);
+    JobSystemSwitchFiber(&mStackPointer, next.mStackPointer);
+}
+
+#else
+
+Fiber::Fiber(size_t, EntryFunction, void *) { std::abort(); }
+
+Fiber::~Fiber() {}
+
+void Fiber::SwitchTo(Fiber &) noexcept { std::abort(); }
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__linux__) && defined(__x86_64__)
+#    define JOBSYSTEM_HAS_FIBERS 1
+#else
+#    define JOBSYSTEM_HAS_FIBERS 0
+#endif
+
+namespace JobSystem
+{
+    /**
+     * Execution context with its own fixed-size stack, switched in user space
+     * Only the callee-saved registers and the FPU/SSE control words are swapped, so a switch costs about as much as a function call.
+     * Stacks are mapped with a guard page below them, an overflow faults instead of silently corrupting a neighbour.
+     * Linux/x86-64 only, check `isSupported`.
+     */
+    class Fiber
+    {
+    public:
+        typedef void (*EntryFunction)(void * argument);
+
+        static constexpr bool isSupported = JOBSYSTEM_HAS_FIBERS != 0;
+
+        // stands for the calling thread's own stack, it can be switched away from and back to
+        Fiber() = default;
+        // `entry` must never return, switch away from it instead
+        Fiber(size_t stackSize, EntryFunction entry, void * argument);
+        ~Fiber();
+
+        Fiber(const Fiber &) = delete;
+        Fiber & operator=(const Fiber &) = delete;
+
+        // saves the current context into this fiber and continues `next`, returns once something switches back to this one
+        void SwitchTo(Fiber & next) noexcept;
+
+        size_t StackSize() const { return mStackSize; }
+
+    private:
+        void * mStackPointer = nullptr;
+        void * mStack = nullptr;
+        size_t mStackSize = 0;
+    };
+
+} // namespace JobSystem
@@ -0,0 +1,79 @@
+#include "FrameArena.h"
+
+#include <cassert>
+
+#include "AlignedMalloc.h"
+
+using namespace JobSystem;
+
+namespace
+{
+    char * AlignUp(char * pointer, size_t alignment)
+    {
+        return reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(pointer) + alignment - 1) & ~(uintptr_t{ alignment } - 1));
+    }
+} // namespace
+
+FrameArena::FrameArena(size_t blockSize) : mBlockSize(blockSize) {}
+
+FrameArena::~FrameArena()
+{
+    for (Block * block = mFirst; block;) {
+        Block * next = block->next;
+        aligned_free(block);
+        block = next;
+    }
+}
+
+void * FrameArena::Allocate(size_t size, size_t alignment) noexcept
+{
+    assert((alignment & (alignment - 1)) == 0);
+    char * pointer = AlignUp(mCursor, alignment);
+    if (!mCursor || pointer + size > mEnd) {
+        if (!NextBlock(size, alignment)) return nullptr;
+        pointer = AlignUp(mCursor, alignment);
+    }
+    mCursor = pointer + size;
+    return pointer;
+}
+
+void FrameArena::Reset() noexcept
+{
+    mCurrent = mFirst;
+    mCursor = mFirst ? DataOf(mFirst) : nullptr;
+    mEnd = mFirst ? mCursor + mFirst->size : nullptr;
+}
+
+bool FrameArena::NextBlock(size_t size, size_t alignment) noexcept
+{
+    // blocks start cacheline aligned, only bigger alignments need extra room
+    const size_t neededSize = size + (alignment > headerSize ? alignment : 0);
+
+    // reuse what the previous frames left behind, as long as it fits
+    while (mCurrent && mCurrent->next) {
+        mCurrent = mCurrent->next;
+        if (mCurrent->size >= neededSize) {
+            mCursor = DataOf(mCurrent);
+            mEnd = mCursor + mCurrent->size;
+            return true;
+        }
+    }
+
+    const size_t blockSize = neededSize > mBlockSize ? neededSize : mBlockSize;
+    auto * block = static_cast<Block *>(aligned_malloc(headerSize + blockSize, headerSize));
+    if (!block) return false;
+    block->size = blockSize;
+    mCapacity += blockSize;
+
+    // appended at the end, so the next frames walk the blocks in the same order
+    block->next = nullptr;
+    if (mCurrent) {
+        mCurrent->next = block;
+    } else {
+        mFirst = block;
+    }
+    mCurrent = block;
+    mCursor = DataOf(block);
+    mEnd = mCursor + blockSize;
+    return true;
+}
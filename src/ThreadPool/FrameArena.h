@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace JobSystem
+{
+    /**
+     * Linear arena, single owner
+     * Allocating bumps a pointer, nothing is freed one by one: `Reset()` drops everything at once and keeps the blocks for reuse.
+     * Blocks of `blockSize` are added as needed, bigger allocations get a block of their own.
+     */
+    class FrameArena
+    {
+    public:
+        explicit FrameArena(size_t blockSize);
+        ~FrameArena();
+
+        FrameArena(const FrameArena &) = delete;
+        FrameArena & operator=(const FrameArena &) = delete;
+
+        // `alignment` is a power of two; nullptr only if the system is out of memory
+        void * Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) noexcept;
+        void Reset() noexcept;
+
+        // bytes of the blocks held
+        size_t Capacity() const { return mCapacity; }
+
+    private:
+        struct Block
+        {
+            Block * next;
+            size_t size; // usable bytes after the header
+        };
+        static constexpr size_t headerSize = 64;
+
+        bool NextBlock(size_t size, size_t alignment) noexcept;
+        static char * DataOf(Block * block) { return reinterpret_cast<char *>(block) + headerSize; }
+
+        size_t mBlockSize;
+        size_t mCapacity = 0;
+        Block * mFirst = nullptr;
+        Block * mCurrent = nullptr;
+        char * mCursor = nullptr;
+        char * mEnd = nullptr;
+    };
+
+} // namespace JobSystem
@@ -0,0 +1,41 @@
+#include "JobAllocator.h"
+
+using namespace JobSystem;
+
+// A freed block stores the pointer to the next free one
+static void *& NextOf(void * block) { return *static_cast<void **>(block); }
+
+JobAllocator::JobAllocator(size_t numElements, size_t elementSize, size_t alignment, PoolBacking backing) : mPool(numElements, elementSize, alignment, 1, backing) {}
+
+void * JobAllocator::Allocate() noexcept
+{
+    if (!mLocalHead) {
+        // take back everything the other threads returned since the last time, with one atomic operation
+        mLocalHead = mRemoteHead.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    if (mLocalHead) {
+        void * block = mLocalHead;
+        mLocalHead = NextOf(block);
+        return block;
+    }
+
+    return mPool.Allocate();
+}
+
+void JobAllocator::Deallocate(void * block) noexcept
+{
+    if (!block) return;
+    NextOf(block) = mLocalHead;
+    mLocalHead = block;
+}
+
+void JobAllocator::DeallocateRemote(void * block) noexcept
+{
+    if (!block) return;
+    // push only, the single consumer takes the whole list so there is no ABA here
+    void * head = mRemoteHead.load(std::memory_order_relaxed);
+    do {
+        NextOf(block) = head;
+    } while (!mRemoteHead.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+}
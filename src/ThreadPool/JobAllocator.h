@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+
+#include "MemoryPoolAllocator.h"
+
+namespace JobSystem
+{
+    /**
+     * Single owner pool allocator, one per worker
+     * The owner allocates and frees through a plain freelist, other threads return blocks through a lock-free stack
+     * which the owner takes over in one go when its own list runs dry.
+     */
+    class JobAllocator
+    {
+    public:
+        JobAllocator(size_t numElements, size_t elementSize, size_t alignment = 16, PoolBacking backing = PoolBacking::Heap);
+
+        JobAllocator(const JobAllocator &) = delete;
+        JobAllocator & operator=(const JobAllocator &) = delete;
+
+        // owner thread only
+        void * Allocate() noexcept;
+        void Deallocate(void * block) noexcept;
+
+        // any thread
+        void DeallocateRemote(void * block) noexcept;
+
+    private:
+        static constexpr size_t cachelineSize = 64;
+
+        // blocks are only handed out by the owner, so this pool is never contended
+        MemoryPoolAllocator mPool;
+        void * mLocalHead = nullptr;
+
+        alignas(cachelineSize) std::atomic<void *> mRemoteHead{ nullptr };
+        char pad0_[cachelineSize - sizeof(std::atomic<void *>)]{};
+    };
+
+} // namespace JobSystem
@@ -1,124 +1,202 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 
 #include "MemoryPoolAllocator.h"
 #include <exception>
+#include <new>
 #include "AlignedMalloc.h"
 
 // Thread-safeness
 // https://stackoverflow.com/questions/12467514/simple-thread-safe-and-fast-memory-pool-implementation
 // https://codereview.stackexchange.com/questions/216762/creating-a-lock-free-memory-pool-using-c11-featuresz
 
+namespace
+{
+  int HugePagesOf(JobSystem::PoolBacking backing)
+  {
+    switch (backing) {
+      case JobSystem::PoolBacking::TransparentHugePages: return PAGE_ALLOC_TRANSPARENT_HUGE;
+      case JobSystem::PoolBacking::HugePages: return PAGE_ALLOC_HUGE;
+      default: return PAGE_ALLOC_SMALL;
+    }
+  }
+} // namespace
 
-JobSystem::MemoryPoolAllocator::MemoryPoolAllocator(size_t numElements, size_t elementSize, size_t alignment)
+
+JobSystem::MemoryPoolAllocator::MemoryPoolAllocator(size_t numElements, size_t elementSize, size_t alignment, size_t maxChunks, PoolBacking backing)
+    : mChunkElements(numElements), mChunkSize(numElements * elementSize), mElementSize(elementSize), mAlignment(alignment), mMaxChunks(maxChunks), mBacking(backing)
 {
-  mHead.store(nullptr);
-  const bool result = AllocatePool(numElements, elementSize, alignment);
-  if (!result) throw std::bad_alloc();
+  // element size must be at least the size of the freelist link
+  assert(mElementSize >= sizeof(uint64_t));
+  // element size must be a multiple of the alignment requirement
+  assert(mElementSize % mAlignment == 0);
+  // alignment must be a power of two
+  assert((mAlignment & (mAlignment - 1)) == 0);
+  // pages are aligned to 4k at least
+  assert(mBacking == PoolBacking::Heap || mAlignment <= 4096);
+  assert(mMaxChunks >= 1 && mMaxChunks <= maxChunkCount);
+  // element indices have to fit into the lower half of the head
+  assert(numElements * mMaxChunks < 0xffffffffu);
+
+  mHead.store(MakeHead(0, emptyIndex));
+  // the first chunk is there right away, so a pool that cannot even get that fails early
+  if (numElements && !AllocateChunk()) throw std::bad_alloc();
 }
 
 JobSystem::MemoryPoolAllocator::~MemoryPoolAllocator() { ReleasePool(); }
 
-bool JobSystem::MemoryPoolAllocator::AllocatePool(size_t numElements, size_t elementSize, size_t alignment)
+bool JobSystem::MemoryPoolAllocator::AllocateChunk()
 {
-  // guarantees that this pool was not allocated before
-  assert(mPool == nullptr);
+  const size_t numChunks = mNumChunks.load(std::memory_order_relaxed);
+  if (numChunks == mMaxChunks) return false;
 
-  mElementSize = elementSize;
-  mAlignment = alignment;
+  // nothing is written into the chunk here, the bump index hands out its blocks as they are first needed
+  void * chunk = mBacking == PoolBacking::Heap ? aligned_malloc(mChunkSize, mAlignment) : page_alloc(mChunkSize, HugePagesOf(mBacking));
+  if (chunk == nullptr) return false;
 
-  // element size must be at least the same size of void*
-  assert(mElementSize >= sizeof(void *));
-  // element size must be a multiple of the alignment requirement
-  assert(mElementSize % mAlignment == 0);
-  // alignment must be a power of two
-  assert((mAlignment & (mAlignment - 1)) == 0);
+  mChunks[numChunks] = static_cast<char *>(chunk);
+  mNumChunks.store(numChunks + 1, std::memory_order_release);
+  return true;
+}
 
-  // --- allocate
-  mPoolSize = (mElementSize * numElements) /*+ alignment*/;
-  mPool = aligned_malloc(mElementSize * numElements, mAlignment);
-  if (mPool == nullptr) return false;
-
-  // ---
-  // cast the void* to void**, so the memory is 'interpret' as a buffer of void*
-  void ** freeMemoryList = static_cast<void **>(mPool);
-  mHead.store(freeMemoryList);
-  // get the address of the end of the memory block
-  const auto endAddress = reinterpret_cast<uintptr_t>(freeMemoryList) + (elementSize * numElements);
-
-  for (size_t element = 0; element < numElements; ++element) {
-    // get the addresses of the current chunck and the next one
-    const auto currAddress = reinterpret_cast<uintptr_t>(freeMemoryList) + element * mElementSize;
-    //    const auto currAddress = static_cast<char*>(freeMemoryList) + element * mElementSize;
-    const auto nextAddress = currAddress + mElementSize;
-    // cast the address of the current chunk to a void**
-    void ** currMemory = reinterpret_cast<void **>(currAddress);
-    if (nextAddress >= endAddress) { // last chunk
-      *currMemory = nullptr;
-    } else {
-      *currMemory = reinterpret_cast<void *>(nextAddress);
+bool JobSystem::MemoryPoolAllocator::Grow(uint64_t numUsed)
+{
+  std::lock_guard<std::mutex> lock(mGrowMutex);
+  // an other thread might have added one meanwhile
+  if (numUsed < mNumChunks.load(std::memory_order_relaxed) * mChunkElements) return true;
+  return AllocateChunk();
+}
+
+void * JobSystem::MemoryPoolAllocator::BlockAt(uint64_t index) const
+{
+  const uint64_t element = index - 1;
+  return mChunks[element / mChunkElements] + (element % mChunkElements) * mElementSize;
+}
+
+uint64_t JobSystem::MemoryPoolAllocator::IndexOfBlock(const void * block) const
+{
+  const char * address = static_cast<const char *>(block);
+  const size_t numChunks = mNumChunks.load(std::memory_order_acquire);
+  for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+    if (address >= mChunks[chunk] && address < mChunks[chunk] + mChunkSize) {
+      return chunk * mChunkElements + static_cast<uint64_t>(address - mChunks[chunk]) / mElementSize + 1;
     }
   }
-  return true;
+  // disallow taking pointers from outside the valid address space
+  assert(false);
+  return emptyIndex;
 }
 
 void * JobSystem::MemoryPoolAllocator::Allocate() noexcept
 {
-  assert(mPool);
-
-  void ** head = nullptr;
-  void ** next = nullptr;
+  uint64_t head = mHead.load(std::memory_order_acquire);
+  uint64_t next = 0;
   void * block = nullptr;
 
-  do {
-    head = mHead.load(std::memory_order_relaxed);
-    // Pool is full
-    if (!head) return nullptr;
-    // Take a block out and tyr to move the head
-    block = reinterpret_cast<void *>(head);
-    next = static_cast<void **>(*head);
+  while (IndexOf(head) != emptyIndex) {
+    // Take a block out and try to move the head
+    block = BlockAt(IndexOf(head));
+    // The block might be handed out and overwritten meanwhile, but then the tag has changed and the CAS fails
+    std::memcpy(&next, block, sizeof(next));
     // If the head was changed by another thread, do it again
-  } while (!mHead.compare_exchange_weak(head, next, std::memory_order_relaxed));
+    if (mHead.compare_exchange_weak(head, MakeHead(TagOf(head) + 1, IndexOf(next)), std::memory_order_acquire, std::memory_order_acquire)) return block;
+  }
 
-  return block;
+  // Nothing to recycle, take a block never used before
+  uint64_t numUsed = mNumUsed.load(std::memory_order_relaxed);
+  for (;;) {
+    if (numUsed >= mNumChunks.load(std::memory_order_acquire) * mChunkElements) {
+      // Pool is full
+      if (!Grow(numUsed)) return nullptr;
+      continue;
+    }
+    if (mNumUsed.compare_exchange_weak(numUsed, numUsed + 1, std::memory_order_relaxed)) return BlockAt(numUsed + 1);
+  }
 }
 
 void JobSystem::MemoryPoolAllocator::Deallocate(void * block) noexcept
 {
   if (block == nullptr) { return; }
 
-  // TODO disallow taking pointef rom outside the valid address space
-
-  assert(mPool);
-
-  void ** head = nullptr;
-  void ** prev = nullptr;
-  void ** returningBlock = nullptr; // where the returning block will point at as a next block (to restore freelist)
+  const uint64_t index = IndexOfBlock(block);
+  uint64_t head = mHead.load(std::memory_order_relaxed);
 
-  while (true) {
-    head = mHead.load(std::memory_order_relaxed);
-
-    if (head == nullptr) {
-      returningBlock = nullptr;
-      // the free list was empty set the head to the returning block then mark as the last one
-      prev = reinterpret_cast<void **>(block);
+  do {
+    // link the returning block before publishing it as the new head
+    const uint64_t next = IndexOf(head);
+    std::memcpy(block, &next, sizeof(next));
+  } while (!mHead.compare_exchange_weak(head, MakeHead(TagOf(head) + 1, index), std::memory_order_release, std::memory_order_relaxed));
+}
 
-    } else {
-      // otherwise put back to the queue as is
-      returningBlock = head;
-      prev = reinterpret_cast<void **>(block);
+size_t JobSystem::MemoryPoolAllocator::AllocateBulk(void ** blocks, size_t numBlocks) noexcept
+{
+  if (numBlocks == 0) return 0;
+
+  // walk the first few links, the CAS fails if any of them got handed out meanwhile
+  uint64_t head = mHead.load(std::memory_order_acquire);
+  size_t numTaken = 0;
+  while (IndexOf(head) != emptyIndex) {
+    // a block handed out meanwhile holds anything instead of a link, never follow it out of the pool
+    const uint64_t capacity = mNumChunks.load(std::memory_order_acquire) * mChunkElements;
+    uint64_t index = IndexOf(head);
+    numTaken = 0;
+    while (index != emptyIndex && index <= capacity && numTaken < numBlocks) {
+      blocks[numTaken++] = BlockAt(index);
+      std::memcpy(&index, blocks[numTaken - 1], sizeof(index));
     }
-
-    // Only mark when change could be committed, otherwise try it again
-    if (mHead.compare_exchange_weak(head, prev, std::memory_order_relaxed)) {
-      *prev = returningBlock;
-      return;
+    if (mHead.compare_exchange_weak(head, MakeHead(TagOf(head) + 1, index), std::memory_order_acquire, std::memory_order_acquire)) break;
+    numTaken = 0;
+  }
+  if (numTaken == numBlocks) return numTaken;
+
+  // the rest are never used blocks, as many as the chunks hold
+  uint64_t numUsed = mNumUsed.load(std::memory_order_relaxed);
+  for (;;) {
+    const uint64_t capacity = mNumChunks.load(std::memory_order_acquire) * mChunkElements;
+    if (numUsed >= capacity) {
+      if (!Grow(numUsed)) return numTaken;
+      continue;
+    }
+    const uint64_t numNew = std::min<uint64_t>(numBlocks - numTaken, capacity - numUsed);
+    if (mNumUsed.compare_exchange_weak(numUsed, numUsed + numNew, std::memory_order_relaxed)) {
+      for (uint64_t i = 0; i < numNew; ++i) { blocks[numTaken++] = BlockAt(numUsed + i + 1); }
+      return numTaken;
     }
   }
 }
 
+void JobSystem::MemoryPoolAllocator::DeallocateBulk(void * const * blocks, size_t numBlocks) noexcept
+{
+  if (numBlocks == 0) return;
+
+  for (size_t i = 0; i + 1 < numBlocks; ++i) {
+    const uint64_t next = IndexOfBlock(blocks[i + 1]);
+    std::memcpy(blocks[i], &next, sizeof(next));
+  }
+
+  const uint64_t index = IndexOfBlock(blocks[0]);
+  void * last = blocks[numBlocks - 1];
+  uint64_t head = mHead.load(std::memory_order_relaxed);
+  do {
+    const uint64_t next = IndexOf(head);
+    std::memcpy(last, &next, sizeof(next));
+  } while (!mHead.compare_exchange_weak(head, MakeHead(TagOf(head) + 1, index), std::memory_order_release, std::memory_order_relaxed));
+}
+
 void JobSystem::MemoryPoolAllocator::ReleasePool()
 {
-  aligned_free(mPool);
-  mPool = mHead = nullptr;
+  const size_t numChunks = mNumChunks.load(std::memory_order_relaxed);
+  for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+    if (mBacking == PoolBacking::Heap) {
+      aligned_free(mChunks[chunk]);
+    } else {
+      page_free(mChunks[chunk], mChunkSize, HugePagesOf(mBacking));
+    }
+    mChunks[chunk] = nullptr;
+  }
+  mNumChunks.store(0, std::memory_order_relaxed);
+  mNumUsed.store(0, std::memory_order_relaxed);
+  mHead = MakeHead(0, emptyIndex);
 }
@@ -1,17 +1,35 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <atomic>
+#include <mutex>
 
 namespace JobSystem
 {
   /**
-   * Bounded pool allocator implementation
+   * Where a pool gets its chunks from
+   * The page backed ones come straight from `mmap` / `VirtualAlloc`; huge pages cut TLB misses, but a chunk then takes at least 2MB.
+   */
+  enum class PoolBacking
+  {
+    Heap,
+    Pages,
+    TransparentHugePages,
+    HugePages // explicit ones, falls back to transparent ones if none are reserved
+  };
+
+  /**
+   * Pool allocator implementation, growing by chunks of `numElements` up to `maxChunks`
+   * Blocks never handed out come from a bump index, so a chunk is only touched as far as it was ever used, and only returned
+   * blocks go through the freelist. The freelist head is an element index with a version tag, so a CAS cannot succeed on a recycled head (ABA)
    */
   class MemoryPoolAllocator
   {
   public:
-    MemoryPoolAllocator(size_t numElements, size_t elementSize, size_t alignment = 16);
+    static constexpr size_t maxChunkCount = 32;
+
+    MemoryPoolAllocator(size_t numElements, size_t elementSize, size_t alignment = 16, size_t maxChunks = 1, PoolBacking backing = PoolBacking::Heap);
 
     MemoryPoolAllocator(const MemoryPoolAllocator & alloc) = delete;
     MemoryPoolAllocator & operator=(const MemoryPoolAllocator & rhs) = delete;
@@ -20,21 +38,46 @@ namespace JobSystem
 
     ~MemoryPoolAllocator();
 
+    // nullptr once every chunk is in use and no more can be added
     void * Allocate() noexcept;
     void Deallocate(void * block) noexcept;
+    // up to `numBlocks` at once with a single CAS on the freelist, and one on the bump index for the rest; returns how many it got
+    size_t AllocateBulk(void ** blocks, size_t numBlocks) noexcept;
+    // links the blocks up first, then publishes all of them with a single CAS
+    void DeallocateBulk(void * const * blocks, size_t numBlocks) noexcept;
     size_t ElementSize() const { return mElementSize; }
-    size_t Capacity() const { return mPoolSize; }
+    // bytes of the chunks added so far
+    size_t Capacity() const { return mNumChunks.load(std::memory_order_relaxed) * mChunkSize; }
 
   private:
-    bool AllocatePool(size_t numElements, size_t elementSize, size_t alignment);
+    bool AllocateChunk();
+    bool Grow(uint64_t numUsed);
     void ReleasePool();
 
-    size_t mPoolSize = 0;
+    // head = tag << 32 | (index + 1), index + 1 == 0 marks the end of the list
+    static constexpr uint64_t emptyIndex = 0;
+    static uint64_t MakeHead(uint64_t tag, uint64_t index) { return (tag << 32) | index; }
+    static uint64_t IndexOf(uint64_t head) { return head & 0xffffffffu; }
+    static uint64_t TagOf(uint64_t head) { return head >> 32; }
+
+    void * BlockAt(uint64_t index) const;
+    uint64_t IndexOfBlock(const void * block) const;
+
+    size_t mChunkElements = 0;
+    size_t mChunkSize = 0;
     size_t mElementSize = 0;
     size_t mAlignment = 0;
+    size_t mMaxChunks = 0;
+    PoolBacking mBacking = PoolBacking::Heap;
+
+    // written under `mGrowMutex` before `mNumChunks` publishes them
+    char * mChunks[maxChunkCount] = {};
+    std::atomic<size_t> mNumChunks{ 0 };
+    std::mutex mGrowMutex;
 
-    void * mPool = nullptr;
-    std::atomic<void **> mHead;
+    std::atomic<uint64_t> mHead;
+    // index of the first block never handed out
+    std::atomic<uint64_t> mNumUsed{ 0 };
   };
 
 } // namespace JobSystem
@@ -0,0 +1,40 @@
+#include "ObjectPool.h"
+
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    std::mutex slotsMutex;
+    std::vector<uint32_t> freeSlots;
+    uint32_t numSlots = 0;
+
+    // the slot goes back with the thread, its magazines are inherited by the next thread taking it
+    struct ThreadSlotHolder
+    {
+        ThreadSlotHolder()
+        {
+            std::lock_guard<std::mutex> lock(slotsMutex);
+            if (freeSlots.empty()) {
+                slot = numSlots++;
+            } else {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+        }
+
+        ~ThreadSlotHolder()
+        {
+            std::lock_guard<std::mutex> lock(slotsMutex);
+            freeSlots.push_back(slot);
+        }
+
+        uint32_t slot;
+    };
+} // namespace
+
+uint32_t JobSystem::Internal::ThreadSlot()
+{
+    thread_local ThreadSlotHolder holder;
+    return holder.slot;
+}
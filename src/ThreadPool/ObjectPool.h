@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "MemoryPoolAllocator.h"
+
+namespace JobSystem
+{
+    namespace Internal
+    {
+        /**
+         * Small index of the calling thread, unique among the running threads
+         * Handed out on first use and given back when the thread exits, so it stays dense when threads come and go.
+         */
+        uint32_t ThreadSlot();
+    } // namespace Internal
+
+    /**
+     * Typed pool on top of `MemoryPoolAllocator`, with a magazine per thread
+     * A thread creates and destroys through its own magazine, which takes and returns half a magazine of blocks at a time with a
+     * single CAS on the shared pool, so most calls touch no shared cache line at all. Threads beyond `numThreadSlots` go to the
+     * shared pool directly. Blocks sitting in magazines count as used, so size the pool for `numThreadSlots * magazineSize` more.
+     * Every object has to be destroyed before the pool.
+     */
+    template<typename T> class ObjectPool
+    {
+    public:
+        static constexpr size_t magazineSize = 32;
+
+        explicit ObjectPool(size_t numObjects, size_t maxChunks = 1, PoolBacking backing = PoolBacking::Heap, size_t numThreadSlots = 64);
+
+        ObjectPool(const ObjectPool &) = delete;
+        ObjectPool & operator=(const ObjectPool &) = delete;
+
+        // nullptr if the pool is exhausted
+        template<typename... ArgTypes> T * Create(ArgTypes &&... args);
+        void Destroy(T * object);
+
+    private:
+        static constexpr size_t alignment = alignof(T) > alignof(uint64_t) ? alignof(T) : alignof(uint64_t);
+        static constexpr size_t elementSize = ((sizeof(T) > sizeof(uint64_t) ? sizeof(T) : sizeof(uint64_t)) + alignment - 1) / alignment * alignment;
+        static constexpr size_t cachelineSize = 64;
+
+        // owned by whichever thread holds the slot
+        struct alignas(cachelineSize) Magazine
+        {
+            void * blocks[magazineSize];
+            size_t numBlocks = 0;
+        };
+
+        Magazine * FindMagazine() const;
+        void * Allocate();
+        void Deallocate(void * block);
+
+        MemoryPoolAllocator mAllocator;
+        size_t mNumThreadSlots;
+        std::unique_ptr<Magazine[]> mMagazines;
+    };
+
+    // ------------------------------------------------------------------------------------------------------------------
+
+    template<typename T>
+    ObjectPool<T>::ObjectPool(size_t numObjects, size_t maxChunks, PoolBacking backing, size_t numThreadSlots)
+        : mAllocator(numObjects, elementSize, alignment, maxChunks, backing), mNumThreadSlots(numThreadSlots), mMagazines(new Magazine[numThreadSlots])
+    {
+    }
+
+    template<typename T> template<typename... ArgTypes> T * ObjectPool<T>::Create(ArgTypes &&... args)
+    {
+        void * block = Allocate();
+        if (!block) return nullptr;
+        try {
+            return new (block) T(std::forward<ArgTypes>(args)...);
+        } catch (...) {
+            Deallocate(block);
+            throw;
+        }
+    }
+
+    template<typename T> void ObjectPool<T>::Destroy(T * object)
+    {
+        if (!object) return;
+        object->~T();
+        Deallocate(object);
+    }
+
+    template<typename T> typename ObjectPool<T>::Magazine * ObjectPool<T>::FindMagazine() const
+    {
+        const uint32_t slot = Internal::ThreadSlot();
+        return slot < mNumThreadSlots ? &mMagazines[slot] : nullptr;
+    }
+
+    template<typename T> void * ObjectPool<T>::Allocate()
+    {
+        Magazine * magazine = FindMagazine();
+        if (!magazine) return mAllocator.Allocate();
+
+        if (magazine->numBlocks == 0) {
+            // refill half of it, the other half is room for what gets destroyed on this thread
+            magazine->numBlocks = mAllocator.AllocateBulk(magazine->blocks, magazineSize / 2);
+            if (magazine->numBlocks == 0) return nullptr;
+        }
+        return magazine->blocks[--magazine->numBlocks];
+    }
+
+    template<typename T> void ObjectPool<T>::Deallocate(void * block)
+    {
+        Magazine * magazine = FindMagazine();
+        if (!magazine) {
+            mAllocator.Deallocate(block);
+            return;
+        }
+
+        if (magazine->numBlocks == magazineSize) {
+            // flush the older half, the newer blocks are still warm in this core's cache
+            mAllocator.DeallocateBulk(magazine->blocks, magazineSize / 2);
+            std::move(magazine->blocks + magazineSize / 2, magazine->blocks + magazineSize, magazine->blocks);
+            magazine->numBlocks -= magazineSize / 2;
+        }
+        magazine->blocks[magazine->numBlocks++] = block;
+    }
+
+} // namespace JobSystem
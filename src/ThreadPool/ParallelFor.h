@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace JobSystem
+{
+    namespace Internal
+    {
+        /**
+         * Splits a range as long as it has more than `count` elements
+         */
+        class CountSplitter
+        {
+        public:
+            explicit CountSplitter(size_t count) : mCount(count) {}
+            bool Split(size_t count) const { return count > mCount; }
+
+        private:
+            size_t mCount;
+        };
+
+        /**
+         * Splits a range as long as its elements take up more than `chunkSize` bytes, e.g. the size of the L1 or L2 cache
+         */
+        class DataSizeSplitter
+        {
+        public:
+            DataSizeSplitter(size_t chunkSize, size_t elementSize) : mChunkSize(chunkSize), mElementSize(elementSize) {}
+            bool Split(size_t count) const { return count * mElementSize > mChunkSize; }
+
+        private:
+            size_t mChunkSize;
+            size_t mElementSize;
+        };
+
+        /**
+         * Picks the leaf size from the number of workers: a few leaves per thread, so stealing can even out the load
+         */
+        class AutoSplitter
+        {
+        public:
+            static const size_t leavesPerThread = 4;
+
+            AutoSplitter(const ThreadPool & threadPool, size_t count, size_t minCount = 1) :
+              mCount(std::max(minCount, count / ((threadPool.NumWorkers() + 1) * leavesPerThread)))
+            {}
+            bool Split(size_t count) const { return count > mCount; }
+
+        private:
+            size_t mCount;
+        };
+
+        // ------------------------------------------------------------------------------------------------------------------
+
+        template<typename FunctionType, typename SplitterType> class ParallelForContext
+        {
+        public:
+            ParallelForContext(ThreadPool & threadPool, FunctionType && function, const SplitterType & splitter) :
+              mThreadPool(threadPool), mFunction(std::forward<FunctionType>(function)), mSplitter(splitter)
+            {}
+
+            void Run(Job * job, size_t begin, size_t count) const
+            {
+                // hand the upper half over as a child and keep going with the lower one, the thieves take the biggest chunks first
+                // a single element is never split, whatever the splitter says
+                while (count > 1 && mSplitter.Split(count)) {
+                    const size_t half = count / 2;
+                    const size_t upperBegin = begin + count - half;
+                    Job * child = mThreadPool.CreateJobAsChild(job, [this, upperBegin, half](Job * childJob) { Run(childJob, upperBegin, half); });
+                    mThreadPool.Schedule(child);
+                    count -= half;
+                }
+                mFunction(begin, count);
+            }
+
+        private:
+            ThreadPool & mThreadPool;
+            typename std::decay<FunctionType>::type mFunction;
+            SplitterType mSplitter;
+        };
+
+        /**
+         * Creates a job that calls `function(begin, count)` over the sub-ranges of `[begin, begin + count)`
+         * The range is split recursively as child jobs, so waiting for the returned job waits for the whole range.
+         * The job is not scheduled, see `ThreadPool::Schedule()`.
+         */
+        template<typename FunctionType, typename SplitterType>
+        Job * ParallelFor(ThreadPool & threadPool, size_t begin, size_t count, FunctionType && function, const SplitterType & splitter)
+        {
+            typedef ParallelForContext<FunctionType, SplitterType> ContextType;
+            // the context lives in the root job until every child has finished, the children only point to it
+            return threadPool.CreateJob([context = ContextType(threadPool, std::forward<FunctionType>(function), splitter), begin, count](Job * job) {
+                context.Run(job, begin, count);
+            });
+        }
+
+    } // namespace Internal
+} // namespace JobSystem
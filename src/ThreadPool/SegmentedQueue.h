@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace JobSystem
+{
+  /**
+   * Unbounded FIFO queue made of fixed size segments, grows one segment at a time and keeps one spare
+   * It takes a lock, meant as the slow path behind a bounded lock-free queue; `IsEmpty()` is lock-free so pollers don't contend.
+   */
+  template<typename T> class SegmentedQueue
+  {
+  public:
+    explicit SegmentedQueue(size_t segmentSize = 256);
+    SegmentedQueue(SegmentedQueue const &) = delete;
+
+    void operator=(SegmentedQueue const &) = delete;
+
+    void Push(T const & data);
+    bool Pop(T & data);
+
+    bool IsEmpty() const noexcept;
+
+    size_t Size() const noexcept;
+
+  private:
+    struct Segment
+    {
+      explicit Segment(size_t size) : items(new T[size]) {}
+
+      std::unique_ptr<T[]> items;
+      size_t begin = 0;
+      size_t end = 0;
+      std::unique_ptr<Segment> next;
+    };
+
+    size_t const mSegmentSize;
+    std::mutex mMutex;
+    std::unique_ptr<Segment> mHead;
+    Segment * mTail = nullptr;
+    std::unique_ptr<Segment> mSpare;
+    std::atomic<size_t> mSize{ 0 };
+  };
+
+  template<typename T> SegmentedQueue<T>::SegmentedQueue(size_t segmentSize) : mSegmentSize(segmentSize) { assert(segmentSize > 0); }
+
+  template<typename T> void SegmentedQueue<T>::Push(T const & data)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mTail || mTail->end == mSegmentSize) {
+      std::unique_ptr<Segment> segment = mSpare ? std::move(mSpare) : std::make_unique<Segment>(mSegmentSize);
+      segment->begin = segment->end = 0;
+      Segment * tail = segment.get();
+      if (mTail) {
+        mTail->next = std::move(segment);
+      } else {
+        mHead = std::move(segment);
+      }
+      mTail = tail;
+    }
+    mTail->items[mTail->end++] = data;
+    mSize.fetch_add(1, std::memory_order_release);
+  }
+
+  template<typename T> bool SegmentedQueue<T>::Pop(T & data)
+  {
+    if (IsEmpty()) return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mHead || mHead->begin == mHead->end) return false;
+
+    data = mHead->items[mHead->begin++];
+    mSize.fetch_sub(1, std::memory_order_relaxed);
+    if (mHead->begin == mHead->end) {
+      // drained, keep it around for the next burst instead of freeing it
+      std::unique_ptr<Segment> next = std::move(mHead->next);
+      if (!next) mTail = nullptr;
+      mSpare = std::move(mHead);
+      mHead = std::move(next);
+    }
+    return true;
+  }
+
+  template<typename T> bool SegmentedQueue<T>::IsEmpty() const noexcept { return mSize.load(std::memory_order_acquire) == 0; }
+
+  template<typename T> size_t SegmentedQueue<T>::Size() const noexcept { return mSize.load(std::memory_order_relaxed); }
+
+} // namespace JobSystem
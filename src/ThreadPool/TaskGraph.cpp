@@ -0,0 +1,143 @@
+#include "TaskGraph.h"
+
+#include <cassert>
+
+using namespace JobSystem::Internal;
+
+TaskGraph::TaskGraph(ThreadPool & threadPool) : mThreadPool(threadPool) { mSubgraphs.emplace_back(); }
+
+TaskGraph::NodeId TaskGraph::AddNode(std::function<void()> function)
+{
+    assert(!IsRunning());
+    mIsCompiled = false;
+    mNodes.push_back({ std::move(function), {} });
+    return mNodes.size() - 1;
+}
+
+void TaskGraph::AddEdge(NodeId from, NodeId to)
+{
+    assert(!IsRunning());
+    assert(from < mNodes.size() && to < mNodes.size() && from != to);
+    mIsCompiled = false;
+    mEdges.emplace_back(from, to);
+}
+
+TaskGraph::SubgraphId TaskGraph::AddSubgraph(std::vector<NodeId> nodes)
+{
+    assert(!IsRunning());
+    mIsCompiled = false;
+    mSubgraphs.push_back(std::move(nodes));
+    return mSubgraphs.size() - 1;
+}
+
+void TaskGraph::Compile()
+{
+    assert(!IsRunning());
+    const size_t numNodes = mNodes.size();
+
+    for (Node & node : mNodes) { node.successors.clear(); }
+    for (const auto & edge : mEdges) { mNodes[edge.first].successors.push_back(edge.second); }
+
+    // the whole graph is every node
+    mSubgraphs[wholeGraph].resize(numNodes);
+    for (NodeId id = 0; id < numNodes; ++id) { mSubgraphs[wholeGraph][id] = id; }
+
+    mPlans.resize(mSubgraphs.size());
+    for (size_t i = 0; i < mSubgraphs.size(); ++i) { BuildPlan(mPlans[i], mSubgraphs[i]); }
+
+    mJobs.reset(new Job[numNodes + 1]);
+    mPendingDependencies.reset(new std::atomic<uint32_t>[numNodes]);
+    for (NodeId id = 0; id < numNodes; ++id) { mPendingDependencies[id].store(0, std::memory_order_relaxed); }
+
+    // the node jobs are set up by every Run()
+    mThreadPool.InitializePersistentJob(&mJobs[numNodes], nullptr, nullptr);
+    mJobs[numNodes].unfinishedJobs.store(0, std::memory_order_relaxed);
+
+    mIsCompiled = true;
+}
+
+void TaskGraph::BuildPlan(Plan & plan, const std::vector<NodeId> & nodes) const
+{
+    const size_t numNodes = mNodes.size();
+    plan.nodes = nodes;
+    plan.roots.clear();
+    plan.contains.assign(numNodes, 0);
+    plan.dependencies.assign(numNodes, 0);
+
+    for (NodeId id : nodes) {
+        assert(id < numNodes && !plan.contains[id]);
+        plan.contains[id] = 1;
+    }
+    for (NodeId id : nodes) {
+        for (NodeId successor : mNodes[id].successors) {
+            if (plan.contains[successor]) plan.dependencies[successor]++;
+        }
+    }
+    for (NodeId id : nodes) {
+        if (plan.dependencies[id] == 0) plan.roots.push_back(id);
+    }
+
+#ifndef NDEBUG
+    // Kahn's algorithm, every node has to be reachable from the roots or there is a cycle
+    std::vector<uint32_t> dependencies = plan.dependencies;
+    std::vector<NodeId> ready = plan.roots;
+    size_t visited = 0;
+    while (!ready.empty()) {
+        const NodeId id = ready.back();
+        ready.pop_back();
+        ++visited;
+        for (NodeId successor : mNodes[id].successors) {
+            if (plan.contains[successor] && --dependencies[successor] == 0) ready.push_back(successor);
+        }
+    }
+    assert(visited == nodes.size() && "TaskGraph has a cycle");
+#endif
+}
+
+void TaskGraph::Run(SubgraphId subgraph)
+{
+    assert(mIsCompiled && subgraph < mPlans.size());
+    assert(!IsRunning());
+
+    const Plan & plan = mPlans[subgraph];
+    mActivePlan = &plan;
+
+    // the root finishes once every node of the plan did
+    Job * root = &mJobs[mNodes.size()];
+    mThreadPool.InitializePersistentJob(root, nullptr, nullptr);
+    root->unfinishedJobs.store(static_cast<char32_t>(plan.nodes.size()), std::memory_order_relaxed);
+    for (NodeId id : plan.nodes) {
+        mThreadPool.InitializePersistentJob(&mJobs[id], &TaskGraph::ExecuteNode, this, root);
+        mPendingDependencies[id].store(plan.dependencies[id], std::memory_order_relaxed);
+    }
+
+    // Schedule() publishes the resets above to whoever picks up the roots
+    for (NodeId id : plan.roots) { mThreadPool.Schedule(&mJobs[id]); }
+}
+
+void TaskGraph::Wait()
+{
+    if (!mIsCompiled) return;
+    Job * root = &mJobs[mNodes.size()];
+    mThreadPool.Wait(root);
+    // a `Run()` right away must not race the worker that finished the last node, an empty plan never had one
+    if (mActivePlan && !mActivePlan->nodes.empty()) mThreadPool.WaitForRelease(root);
+}
+
+bool TaskGraph::IsRunning() const { return mIsCompiled && mJobs[mNodes.size()].unfinishedJobs.load(std::memory_order_acquire) != 0; }
+
+void TaskGraph::ExecuteNode(Job * job, void * data)
+{
+    auto * graph = static_cast<TaskGraph *>(data);
+    const NodeId id = static_cast<NodeId>(job - graph->mJobs.get());
+    const Node & node = graph->mNodes[id];
+
+    if (node.function) node.function();
+
+    const Plan & plan = *graph->mActivePlan;
+    for (NodeId successor : node.successors) {
+        if (plan.contains[successor] && graph->mPendingDependencies[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            graph->mThreadPool.Schedule(&graph->mJobs[successor]);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace JobSystem
+{
+    namespace Internal
+    {
+        /**
+         * Static DAG of jobs that can be executed many times
+         * Nodes and edges are declared up front, `Compile()` precomputes the successors and dependency counts,
+         * after that a `Run()` only resets counters of persistent jobs and schedules the roots, nothing gets allocated.
+         * A subgraph runs a subset of the nodes, only taking the edges between them into account.
+         */
+        class TaskGraph
+        {
+        public:
+            typedef size_t NodeId;
+            typedef size_t SubgraphId;
+
+            static const SubgraphId wholeGraph = 0;
+
+            explicit TaskGraph(ThreadPool & threadPool);
+
+            TaskGraph(const TaskGraph &) = delete;
+            TaskGraph & operator=(const TaskGraph &) = delete;
+
+            NodeId AddNode(std::function<void()> function);
+            // `to` runs after `from` has finished
+            void AddEdge(NodeId from, NodeId to);
+            SubgraphId AddSubgraph(std::vector<NodeId> nodes);
+
+            void Compile();
+
+            void Run(SubgraphId subgraph = wholeGraph);
+            void Wait();
+
+            bool IsRunning() const;
+            size_t NumNodes() const { return mNodes.size(); }
+
+        private:
+            struct Node
+            {
+                std::function<void()> function;
+                std::vector<NodeId> successors;
+            };
+
+            struct Plan
+            {
+                std::vector<NodeId> nodes;
+                std::vector<NodeId> roots;
+                std::vector<uint8_t> contains;       // by NodeId
+                std::vector<uint32_t> dependencies; // by NodeId, predecessors inside the plan
+            };
+
+            static void ExecuteNode(Job * job, void * data);
+            void BuildPlan(Plan & plan, const std::vector<NodeId> & nodes) const;
+
+            ThreadPool & mThreadPool;
+            std::vector<Node> mNodes;
+            std::vector<std::pair<NodeId, NodeId>> mEdges;
+            std::vector<std::vector<NodeId>> mSubgraphs;
+
+            // --- compiled
+            bool mIsCompiled = false;
+            std::vector<Plan> mPlans;
+            std::unique_ptr<Job[]> mJobs; // one per node, the last one is the root every node is a child of
+            std::unique_ptr<std::atomic<uint32_t>[]> mPendingDependencies;
+            const Plan * mActivePlan = nullptr;
+        };
+
+    } // namespace Internal
+} // namespace JobSystem
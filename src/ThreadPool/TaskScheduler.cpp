@@ -1,3 +1,3 @@
 #include "TaskScheduler.h"
 
-
+JobSystem::TaskScheduler::TaskScheduler(size_t numThreads) : mThreadPool(numThreads), mFutureStates(maxFutureCount, futureStateSize, futureStateSize) {}
@@ -1,35 +1,174 @@
 #pragma once
 
+#include <atomic>
+#include <cassert>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 #include "ThreadPool.h"
+#include "MemoryPoolAllocator.h"
 
 namespace JobSystem
 {
+  namespace Internal
+  {
+    /**
+     * Shared state between an `Async()` job and its `Future`, the result is constructed in place
+     */
+    template<typename ResultType> struct FutureState
+    {
+      std::atomic<bool> isReady{ false };
+      MemoryPoolAllocator * allocator = nullptr; // nullptr if it did not fit into the pool and came from the heap
+      alignas(ResultType) unsigned char value[sizeof(ResultType)];
 
-  class TaskScheduler
+      template<typename... Args> void SetValue(Args &&... args)
+      {
+        new (value) ResultType(std::forward<Args>(args)...);
+        isReady.store(true, std::memory_order_release);
+      }
+      ResultType & Value() { return *std::launder(reinterpret_cast<ResultType *>(value)); }
+      void DestroyValue() { Value().~ResultType(); }
+    };
+
+    template<> struct FutureState<void>
+    {
+      std::atomic<bool> isReady{ false };
+      MemoryPoolAllocator * allocator = nullptr;
+
+      void SetValue() { isReady.store(true, std::memory_order_release); }
+      void DestroyValue() {}
+    };
+  } // namespace Internal
+
+  /**
+   * Result of `TaskScheduler::Async()`
+   * Waiting executes other jobs on the calling thread instead of blocking it, like `ThreadPool::Wait()`.
+   * Move only; destroying a future that is not ready yet waits for it.
+   */
+  template<typename ResultType> class Future
   {
   public:
-    TaskScheduler();
+    Future() = default;
+    Future(Internal::ThreadPool * threadPool, Internal::FutureState<ResultType> * state) : mThreadPool(threadPool), mState(state) {}
+    ~Future() { Release(); }
+
+    Future(const Future &) = delete;
+    Future & operator=(const Future &) = delete;
+    Future(Future && other) noexcept : mThreadPool(other.mThreadPool), mState(other.mState) { other.mState = nullptr; }
+    Future & operator=(Future && other) noexcept
+    {
+      if (this != &other) {
+        Release();
+        mThreadPool = other.mThreadPool;
+        mState = other.mState;
+        other.mState = nullptr;
+      }
+      return *this;
+    }
+
+    bool IsValid() const { return mState != nullptr; }
+    bool IsReady() const { return mState && mState->isReady.load(std::memory_order_acquire); }
+
+    void Wait() const
+    {
+      assert(mState);
+      mThreadPool->WaitFor([this]() { return IsReady(); });
+    }
+
+    // waits, then moves the result out; the future is invalid afterwards
+    ResultType Get()
+    {
+      Wait();
+      if constexpr (std::is_void<ResultType>::value) {
+        Release();
+      } else {
+        ResultType result(std::move(mState->Value()));
+        Release();
+        return result;
+      }
+    }
+
+  private:
+    void Release()
+    {
+      if (!mState) return;
+      Wait();
+      mState->DestroyValue();
+      MemoryPoolAllocator * allocator = mState->allocator;
+      if (allocator) {
+        mState->~FutureState();
+        allocator->Deallocate(mState);
+      } else {
+        delete mState;
+      }
+      mState = nullptr;
+    }
 
-    //    template<typename FunctionType, typename... Args> std::future<typename std::result_of<FunctionType(Args...)>::type> Async(FunctionType && job, Args &&... args);
+    Internal::ThreadPool * mThreadPool = nullptr;
+    Internal::FutureState<ResultType> * mState = nullptr;
+  };
+
+  class TaskScheduler
+  {
+  public:
+    static const size_t maxFutureCount = 4096;
+    // future states up to this size come from a pool, bigger results from the heap
+    static const size_t futureStateSize = Internal::cachelineSize;
 
-    // ------------------------------------------------------------------------------------------------------------------
+    explicit TaskScheduler(size_t numThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
 
-    //  template<typename FunctionType, typename... Args> std::future<typename std::result_of<FunctionType(Args...)>::type> ThreadPool::Async(FunctionType && job, Args &&... args)
-    //  {
-    //    using ReturnType = typename std::result_of<FunctionType(Args...)>::type;
-    //    auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::bind(std::forward<FunctionType>(job), std::forward<Args>(args)...));
-    //    std::future<ReturnType> res = task->get_future();
+    /**
+     * Runs `function(args...)` as a job, the callable and its arguments are stored inside the job if they fit
+     */
+    template<typename FunctionType, typename... Args>
+    Future<typename std::invoke_result<typename std::decay<FunctionType>::type, typename std::decay<Args>::type...>::type> Async(FunctionType && function, Args &&... args);
 
-    // TODO:
-    //    if (mIsStop) throw std::runtime_error("Cannot add new tasks to a stopped ThreadPool");
-    //    const Job taskWrapper({ [task]() { (*task)(); } });
-    //    if (!mQueue.Push(taskWrapper)) throw std::runtime_error("bounded task queue is full you cannot add more.");
-    //    return res;
-    //  }
+    Internal::ThreadPool & GetThreadPool() { return mThreadPool; }
 
   private:
-      Internal::ThreadPool mThreadPool;
+    template<typename ResultType> Internal::FutureState<ResultType> * CreateFutureState();
+
+    Internal::ThreadPool mThreadPool;
+    MemoryPoolAllocator mFutureStates;
   };
 
+  // ------------------------------------------------------------------------------------------------------------------
+
+  template<typename ResultType> Internal::FutureState<ResultType> * TaskScheduler::CreateFutureState()
+  {
+    typedef Internal::FutureState<ResultType> StateType;
+    if constexpr (sizeof(StateType) <= futureStateSize && alignof(StateType) <= futureStateSize) {
+      void * memory = mFutureStates.Allocate();
+      if (memory) {
+        auto * state = new (memory) StateType();
+        state->allocator = &mFutureStates;
+        return state;
+      }
+    }
+    return new StateType();
+  }
+
+  template<typename FunctionType, typename... Args>
+  Future<typename std::invoke_result<typename std::decay<FunctionType>::type, typename std::decay<Args>::type...>::type> TaskScheduler::Async(FunctionType && function, Args &&... args)
+  {
+    typedef typename std::invoke_result<typename std::decay<FunctionType>::type, typename std::decay<Args>::type...>::type ResultType;
+
+    Internal::FutureState<ResultType> * state = CreateFutureState<ResultType>();
+    Internal::Job * job = mThreadPool.CreateJob(
+      [state, function = std::forward<FunctionType>(function), arguments = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        if constexpr (std::is_void<ResultType>::value) {
+          std::apply(std::move(function), std::move(arguments));
+          state->SetValue();
+        } else {
+          state->SetValue(std::apply(std::move(function), std::move(arguments)));
+        }
+      });
+    mThreadPool.Schedule(job);
+
+    return Future<ResultType>(&mThreadPool, state);
+  }
 
 } // namespace JobSystem
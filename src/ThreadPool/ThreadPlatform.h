@@ -17,3 +17,14 @@
 #else
 #    define NOEXCEPT
 #endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#    include <intrin.h>
+#    define CPU_PAUSE() _mm_pause()
+#elif defined(__x86_64__) || defined(__i386__)
+#    define CPU_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#    define CPU_PAUSE() __asm__ __volatile__("yield")
+#else
+#    define CPU_PAUSE() ((void)0)
+#endif
@@ -1,33 +1,121 @@
 #include "ThreadPool.h"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+
 using namespace JobSystem::Internal;
 
 thread_local Worker * localWorker = nullptr;
 
-ThreadPool::ThreadPool(const size_t numThreads) : mNumWorkers(numThreads), mAllocator(numThreads * ThreadPool::maxJobCount, sizeof(Job), 16), mainThreadId(std::this_thread::get_id())
+Worker::Worker(ThreadPool * threadPool)
+    : mThreadPool(threadPool), mJobAllocator(ThreadPool::maxJobCount, sizeof(Job), alignof(Job), threadPool->mConfig.jobPoolBacking),
+      mFrameArenas{ FrameArena(threadPool->mConfig.frameArenaBlockSize), FrameArena(threadPool->mConfig.frameArenaBlockSize) }
+{
+}
+
+namespace
+{
+    // Marsaglia's xorshift32; std::rand() would serialize every thief on a global lock
+    uint32_t NextRandom(uint32_t & state)
+    {
+        uint32_t x = state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state = x;
+        return x;
+    }
+
+    const size_t highPriorityLane = static_cast<size_t>(Priority::High);
+
+    // marks a continuation list that has already been taken by Finish()
+    Job * const closedContinuations = reinterpret_cast<Job *>(uintptr_t{ 1 });
+
+    void Trace(Worker * worker, TraceEventType type)
+    {
+        if (worker && worker->mTrace) worker->mTrace->Record(type);
+    }
+
+    void Trace(Worker * worker, TraceEventType type, const Job & job)
+    {
+        if (worker && worker->mTrace) worker->mTrace->Record(type, reinterpret_cast<uintptr_t>(job.function), job.label);
+    }
+} // namespace
+
+ThreadPool::ThreadPool(const size_t numThreads, const ThreadPoolConfig & config) : mConfig(config), mNumWorkers(numThreads), mTraceStart(TraceBuffer::Now()), mAllocator(ThreadPool::maxJobCount, sizeof(Job), alignof(Job), std::min<size_t>(std::max<uint32_t>(config.maxSharedJobChunks, 1), MemoryPoolAllocator::maxChunkCount), config.jobPoolBacking),
+      mSharedFrameArenas{ FrameArena(config.frameArenaBlockSize), FrameArena(config.frameArenaBlockSize) }, mainThreadId(std::this_thread::get_id())
 {
     assert(mNumWorkers);
+    mConfig.useFibers = mConfig.useFibers && Fiber::isSupported;
+    mConfig.minWorkers = static_cast<uint32_t>(std::min<size_t>(std::max<uint32_t>(mConfig.minWorkers, 1), mNumWorkers));
+    mNumActiveWorkers.store(mNumWorkers, std::memory_order_relaxed);
+    mFrameRoot = std::make_unique<Job>();
+    InitializePersistentJob(mFrameRoot.get(), nullptr, nullptr);
 
-    for (size_t i = 0; i < mNumWorkers; ++i) { mWorkers.push_back(std::make_unique<Worker>()); }
+    if (mConfig.pinThreads) mTopology = CpuTopology::Discover();
 
+    // the main and the external workers have to exist before any thread would try to steal from them
+    mMainWorker = std::make_unique<Worker>(this);
+    mMainWorker->mRandomState = static_cast<uint32_t>(0x9E3779B9u * (mNumWorkers + 1));
+    if (mConfig.traceEventsPerWorker) mMainWorker->mTrace = std::make_unique<TraceBuffer>(mConfig.traceEventsPerWorker);
+    for (uint32_t i = 0; i < mConfig.externalThreadSlots; ++i) {
+        auto worker = std::make_unique<Worker>(this);
+        worker->mRandomState = static_cast<uint32_t>(0x9E3779B9u * (mNumWorkers + 2 + i));
+        if (mConfig.traceEventsPerWorker) worker->mTrace = std::make_unique<TraceBuffer>(mConfig.traceEventsPerWorker);
+        mExternalWorkers.push_back(std::move(worker));
+    }
+    mWorkers.resize(mNumWorkers);
+
+    const std::vector<size_t> placement = mTopology.PlacementOrder();
     for (size_t i = 0; i < numThreads; ++i) {
-        mThreads.emplace_back(
-          [this](Worker * worker) {
-              localWorker = worker;
-              while (!localWorker->mIsTerminated) {
-                  Job * job = GetJob();
-                  if (job) { Execute(job); }
-              }
-          },
-          mWorkers[i].get());
+        const size_t cpuIndex = placement.empty() ? noCpu : placement[i % placement.size()];
+        mThreads.emplace_back([this, i, cpuIndex]() {
+            if (cpuIndex != noCpu) CpuTopology::PinCurrentThread(mTopology.Cpus()[cpuIndex].id);
+
+            // built on its own thread, so once pinned, its queues, job pool and fiber stacks get first touched on the local node
+            auto worker = std::make_unique<Worker>(this);
+            worker->mCpuIndex = cpuIndex;
+            worker->mRandomState = static_cast<uint32_t>(0x9E3779B9u * (i + 1));
+            if (mConfig.traceEventsPerWorker) worker->mTrace = std::make_unique<TraceBuffer>(mConfig.traceEventsPerWorker);
+            // threads that don't belong to the pool keep waiting on their own stack, they might not come back to resume a fiber
+            if (mConfig.useFibers) InitializeFibers(worker.get());
+            localWorker = worker.get();
+            mWorkers[i] = std::move(worker);
+
+            mNumStartedWorkers.fetch_add(1, std::memory_order_release);
+            WaitForWorkers();
+            FindVictims(localWorker);
+
+            if (mConfig.useFibers) {
+                RunFibers(localWorker);
+                return;
+            }
+            uint32_t idleRounds = 0;
+            while (!localWorker->mIsTerminated) {
+                Job * job = GetJob();
+                if (!job) { job = Idle(localWorker, idleRounds++); }
+                if (job) {
+                    if (idleRounds) EndIdle(localWorker);
+                    Execute(job);
+                    idleRounds = 0;
+                }
+            }
+        });
     }
 
-    mMainWorker = std::make_unique<Worker>();
+    WaitForWorkers();
+    FindVictims(mMainWorker.get());
+    for (auto & worker : mExternalWorkers) FindVictims(worker.get());
 }
 
 ThreadPool::~ThreadPool()
 {
     for (auto & worker : mWorkers) worker->mIsTerminated = true;
+    mSleepers.NotifyAll();
+    mRetiredWorkers.NotifyAll();
     for (auto & thread : mThreads) thread.join();
 }
 
@@ -37,6 +125,12 @@ Job * ThreadPool::CreateJob(JobFunction function, void * data)
     job->function = function;
     job->parent = nullptr;
     job->data = data;
+    job->destructor = nullptr;
+    job->continuations.store(nullptr, std::memory_order_relaxed);
+    job->nextContinuation = nullptr;
+    job->flags = 0;
+    job->priority = Priority::Normal;
+    job->label = 0;
     job->unfinishedJobs = 1;
 
     return job;
@@ -50,46 +144,449 @@ Job * ThreadPool::CreateJobAsChild(Job * parent, JobFunction function, void * da
     job->function = function;
     job->parent = parent;
     job->data = data;
+    job->destructor = nullptr;
+    job->continuations.store(nullptr, std::memory_order_relaxed);
+    job->nextContinuation = nullptr;
+    job->flags = 0;
+    job->priority = parent->priority;
+    job->label = 0;
     job->unfinishedJobs = 1;
 
     return job;
 }
 
-#pragma clang diagnostic push
-#pragma ide diagnostic ignored "cert-msc30-c"
+void ThreadPool::Schedule(Job * job, const Priority priority)
+{
+    assert(job);
+    job->priority = priority;
+    Schedule(job);
+}
+
 void ThreadPool::Schedule(Job * job)
 {
     assert(job);
-    const auto randomIndex = static_cast<size_t>(std::rand()) % (mNumWorkers);
-    mWorkers[randomIndex]->mQueue.Push(job);
+    // only the owner may push into a work-stealing queue, the others pick it up by stealing
+    Worker * worker = FindWorker();
+    job->framePath = mIsInFrame.load(std::memory_order_relaxed) ? FramePathOf(worker) : 0;
+    if (!worker) {
+        Inject(job);
+        return;
+    }
+    const auto lane = static_cast<size_t>(job->priority);
+    JOBSYSTEM_COUNT(worker, jobsScheduled, 1);
+    if (!worker->mQueues[lane].Push(job)) {
+        JOBSYSTEM_COUNT(worker, failedPushes, 1);
+        switch (mConfig.overflowPolicy) {
+            case OverflowPolicy::Spill: mOverflow[lane].Push(job); break;
+            case OverflowPolicy::RunInline: Execute(job); return;
+            case OverflowPolicy::Backpressure:
+                // our own queue hands out its newest jobs first, so room frees up quickly
+                do {
+                    if (Job * otherJob = GetJob()) {
+                        Execute(otherJob);
+                    } else {
+                        Yield();
+                    }
+                } while (!worker->mQueues[lane].Push(job));
+                break;
+        }
+    }
+    JOBSYSTEM_COUNT_MAX(worker, queueHighWater, worker->mQueues[lane].Size());
+    if (mConfig.elasticWorkers) GrowIfBacklogged(worker->mQueues[lane].Size());
+    if (lane == highPriorityLane) mHasHighPriorityJobs.store(true, std::memory_order_release);
+    // one new job, one sleeper to pick it up
+    if (mConfig.idlePolicy == IdlePolicy::Adaptive) mSleepers.Notify(1);
 }
 
+void ThreadPool::ScheduleBatch(Job * const * jobs, const size_t numJobs)
+{
+    Worker * worker = FindWorker();
+    const int64_t framePath = mIsInFrame.load(std::memory_order_relaxed) ? FramePathOf(worker) : 0;
+    for (size_t i = 0; i < numJobs; ++i) jobs[i]->framePath = framePath;
+    size_t first = 0;
+    while (first < numJobs) {
+        const Priority priority = jobs[first]->priority;
+        size_t last = first + 1;
+        while (last < numJobs && jobs[last]->priority == priority) ++last;
+
+        const auto lane = static_cast<size_t>(priority);
+        size_t numPushed = 0;
+        if (worker) {
+            numPushed = worker->mQueues[lane].PushBulk(jobs + first, last - first);
+            JOBSYSTEM_COUNT(worker, jobsScheduled, numPushed);
+            JOBSYSTEM_COUNT_MAX(worker, queueHighWater, worker->mQueues[lane].Size());
+            if (mConfig.elasticWorkers) GrowIfBacklogged(worker->mQueues[lane].Size());
+        } else {
+            numPushed = mInjected[lane].PushBulk(jobs + first, last - first);
+            if (mConfig.elasticWorkers) GrowIfBacklogged(mInjected[lane].Size());
+        }
+        if (numPushed && lane == highPriorityLane) mHasHighPriorityJobs.store(true, std::memory_order_release);
+        // whatever did not fit is up to the overflow policy
+        for (size_t i = first + numPushed; i < last; ++i) Schedule(jobs[i]);
+        first = last;
+    }
+    if (mConfig.idlePolicy == IdlePolicy::Adaptive) mSleepers.Notify(static_cast<uint32_t>(std::min<size_t>(numJobs, UINT32_MAX)));
+}
+
+void ThreadPool::Inject(Job * job)
+{
+    // a thread without a worker has nothing to help with, so whatever the overflow policy, a full queue spills
+    const auto lane = static_cast<size_t>(job->priority);
+    if (!mInjected[lane].Push(job)) mOverflow[lane].Push(job);
+    if (mConfig.elasticWorkers) GrowIfBacklogged(mInjected[lane].Size());
+    if (lane == highPriorityLane) mHasHighPriorityJobs.store(true, std::memory_order_release);
+    if (mConfig.idlePolicy == IdlePolicy::Adaptive) mSleepers.Notify(1);
+}
+
+void ThreadPool::GrowIfBacklogged(const size_t queueDepth)
+{
+    if (queueDepth <= mConfig.growQueueDepth || mNumActiveWorkers.load(std::memory_order_relaxed) == mNumWorkers) return;
+
+    // whoever clears the flag brings that worker back, the others look for an other one
+    for (auto & worker : mWorkers) {
+        bool isRetired = true;
+        if (worker->mIsRetired.compare_exchange_strong(isRetired, false, std::memory_order_acq_rel)) {
+            mNumActiveWorkers.fetch_add(1, std::memory_order_relaxed);
+            mRetiredWorkers.NotifyAll();
+            return;
+        }
+    }
+}
+
+bool ThreadPool::Retire(Worker * worker)
+{
+    // nobody else would resume a fiber waiting on this worker
+    if (worker->mNumSuspendedFibers) return false;
+    size_t numActiveWorkers = mNumActiveWorkers.load(std::memory_order_relaxed);
+    do {
+        if (numActiveWorkers <= mConfig.minWorkers) return false;
+    } while (!mNumActiveWorkers.compare_exchange_weak(numActiveWorkers, numActiveWorkers - 1, std::memory_order_relaxed));
+
+    JOBSYSTEM_COUNT(worker, retirements, 1);
+    worker->mIsRetired.store(true, std::memory_order_release);
+
+    // only the owner pushes into its queues, so once they are drained nothing gets stuck in them while it sleeps
+    uint32_t numMigrated = 0;
+    for (size_t lane = 0; lane < priorityCount; ++lane) {
+        Job * job = nullptr;
+        while (worker->mQueues[lane].Pop(job)) {
+            mOverflow[lane].Push(job);
+            ++numMigrated;
+            if (lane == highPriorityLane) mHasHighPriorityJobs.store(true, std::memory_order_release);
+        }
+    }
+    if (numMigrated && mConfig.idlePolicy == IdlePolicy::Adaptive) mSleepers.Notify(numMigrated);
+
+    for (;;) {
+        const uint32_t epoch = mRetiredWorkers.PrepareWait();
+        if (!worker->mIsRetired.load(std::memory_order_acquire) || worker->mIsTerminated) {
+            mRetiredWorkers.CancelWait();
+            return true;
+        }
+        mRetiredWorkers.CommitWait(epoch);
+    }
+}
 
 Job * ThreadPool::AllocateJob()
 {
-    Job * job = reinterpret_cast<Job *>(mAllocator.Allocate());
-    assert(job);
+    Worker * worker = FindWorker();
+    for (;;) {
+        if (worker) {
+            if (void * block = worker->mJobAllocator.Allocate()) {
+                Job * job = reinterpret_cast<Job *>(block);
+                job->allocator = &worker->mJobAllocator;
+                return job;
+            }
+        }
+        if (void * block = mAllocator.Allocate()) {
+            Job * job = reinterpret_cast<Job *>(block);
+            job->allocator = nullptr;
+            return job;
+        }
+
+        // every job is in flight, help finishing them until some get released
+        Job * otherJob = worker ? GetJob() : nullptr;
+        if (otherJob) {
+            Execute(otherJob);
+        } else {
+            Yield();
+        }
+    }
+}
+
+void ThreadPool::Deallocate(Job * job)
+{
+    JobAllocator * allocator = job->allocator;
+    if (!allocator) {
+        mAllocator.Deallocate(job);
+        return;
+    }
+
+    // the common case is finishing a job on the thread that created it
+    Worker * worker = FindWorker();
+    if (worker && allocator == &worker->mJobAllocator) {
+        allocator->Deallocate(job);
+    } else {
+        allocator->DeallocateRemote(job);
+    }
+}
+
+void ThreadPool::WaitForWorkers()
+{
+    while (mNumStartedWorkers.load(std::memory_order_acquire) != mNumWorkers) { Yield(); }
+}
+
+void ThreadPool::FindVictims(Worker * thief)
+{
+    // one tier per distance, workers that are not pinned and the main thread count as remote
+    std::vector<Worker *> tiers[cpuDistanceCount];
+    const size_t remoteTier = cpuDistanceCount - 1;
+    for (auto & worker : mWorkers) {
+        if (worker.get() == thief) continue;
+        const bool isPlaced = thief->mCpuIndex != noCpu && worker->mCpuIndex != noCpu;
+        tiers[isPlaced ? static_cast<size_t>(mTopology.Distance(thief->mCpuIndex, worker->mCpuIndex)) : remoteTier].push_back(worker.get());
+    }
+    if (thief != mMainWorker.get()) tiers[remoteTier].push_back(mMainWorker.get());
+    for (auto & worker : mExternalWorkers) {
+        if (worker.get() != thief) tiers[remoteTier].push_back(worker.get());
+    }
+
+    for (const auto & tier : tiers) {
+        if (tier.empty()) continue;
+        thief->mVictims.insert(thief->mVictims.end(), tier.begin(), tier.end());
+        thief->mVictimTiers.push_back(thief->mVictims.size());
+    }
+}
+
+Job * ThreadPool::Steal(Worker * thief, const size_t lane)
+{
+    // sweep the closest tier first, only go further once it is empty;
+    // within a tier start from a random victim so the thieves don't gang up on the same queue
+    size_t tierBegin = 0;
+    for (const size_t tierEnd : thief->mVictimTiers) {
+        const size_t numVictims = tierEnd - tierBegin;
+        const size_t first = NextRandom(thief->mRandomState) % numVictims;
+        for (size_t i = 0; i < numVictims; ++i) {
+            Worker * victim = thief->mVictims[tierBegin + (first + i) % numVictims];
+
+            Job * stolenJob = nullptr;
+            JOBSYSTEM_COUNT(thief, stealAttempts, 1);
+            if (victim->mQueues[lane].Steal(stolenJob)) {
+                JOBSYSTEM_COUNT(thief, stealSuccesses, 1);
+                Trace(thief, TraceEventType::Steal, *stolenJob);
+                StealMore(thief, victim, lane);
+                return stolenJob;
+            }
+        }
+        tierBegin = tierEnd;
+    }
+    return nullptr;
+}
+
+void ThreadPool::StealMore(Worker * thief, Worker * victim, const size_t lane)
+{
+    // steal half: move up to half of what the victim has left into our own queue, so we don't come back for every single job
+    // each one is still a separate CAS, taking a range at once would race with the owner's Pop()
+    JobQueue & victimQueue = victim->mQueues[lane];
+    JobQueue & ownQueue = thief->mQueues[lane];
+    const size_t maxJobs = std::min<size_t>(victimQueue.Size() / 2, mConfig.stealBatchLimit ? mConfig.stealBatchLimit - 1 : 0);
+    uint32_t numStolen = 0;
+    for (; numStolen < maxJobs && ownQueue.Size() < ownQueue.Capacity(); ++numStolen) {
+        Job * job = nullptr;
+        if (!victimQueue.Steal(job)) break;
+        ownQueue.Push(job);
+    }
+    // the surplus is up for grabs, like a batch we scheduled ourselves
+    if (numStolen && mConfig.idlePolicy == IdlePolicy::Adaptive) mSleepers.Notify(numStolen);
+}
+
+Job * ThreadPool::StealHighPriority(Worker * thief)
+{
+    if (!mHasHighPriorityJobs.load(std::memory_order_relaxed)) return nullptr;
+
+    // clear before looking, so a job scheduled meanwhile sets it again; if we found one, there might be more
+    mHasHighPriorityJobs.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Job * job = nullptr;
+    // spilled and retired workers' jobs too, they are flagged just the same
+    if (!mInjected[highPriorityLane].Pop(job) && !mOverflow[highPriorityLane].Pop(job)) job = Steal(thief, highPriorityLane);
+    if (job) mHasHighPriorityJobs.store(true, std::memory_order_relaxed);
     return job;
 }
 
-void ThreadPool::Deallocate(Job * job) { mAllocator.Deallocate(job); }
+void ThreadPool::AddContinuation(Job * antecedent, Job * continuation)
+{
+    assert(antecedent && continuation);
+    Job * head = antecedent->continuations.load(std::memory_order_acquire);
+    do {
+        if (head == closedContinuations) {
+            // too late, the antecedent has already finished
+            RunContinuation(continuation);
+            return;
+        }
+        continuation->nextContinuation = head;
+    } while (!antecedent->continuations.compare_exchange_weak(head, continuation, std::memory_order_release, std::memory_order_acquire));
+}
+
+void ThreadPool::InitializePersistentJob(Job * job, JobFunction function, void * data, Job * parent)
+{
+    job->function = function;
+    job->parent = parent;
+    job->data = data;
+    job->allocator = nullptr;
+    job->destructor = nullptr;
+    job->continuations.store(nullptr, std::memory_order_relaxed);
+    job->nextContinuation = nullptr;
+    job->flags = jobFlagPersistent;
+    job->priority = Priority::Normal;
+    job->label = 0;
+    job->unfinishedJobs.store(1, std::memory_order_relaxed);
+}
+
+void ThreadPool::WaitForRelease(const Job * job)
+{
+    // Finish() closes the continuations right after taking the counter to zero
+    while (job->continuations.load(std::memory_order_acquire) != closedContinuations) Yield();
+}
 
-void ThreadPool::Steal(JobQueue *& stolenQueue)
+void * ThreadPool::AllocateFrame(const size_t size, const size_t alignment)
 {
-    auto randomIndex = static_cast<size_t>(std::rand()) % (mNumWorkers);
-    stolenQueue = &mWorkers[randomIndex]->mQueue;
+    // frames of the same parity share an arena, the first allocation in a newer frame drops what the older one left
+    const uint64_t frame = Frame();
+    const size_t parity = frame & 1;
+    Worker * worker = FindWorker();
+    if (!worker) {
+        std::lock_guard<std::mutex> lock(mFrameArenaMutex);
+        if (mSharedArenaFrames[parity] != frame) {
+            mSharedFrameArenas[parity].Reset();
+            mSharedArenaFrames[parity] = frame;
+        }
+        return mSharedFrameArenas[parity].Allocate(size, alignment);
+    }
+
+    if (worker->mArenaFrames[parity] != frame) {
+        worker->mFrameArenas[parity].Reset();
+        worker->mArenaFrames[parity] = frame;
+    }
+    return worker->mFrameArenas[parity].Allocate(size, alignment);
+}
+
+void ThreadPool::ResetFrame() { mFrame.fetch_add(1, std::memory_order_acq_rel); }
+
+void ThreadPool::BeginFrame(const int64_t budgetNanoseconds)
+{
+    assert(!mIsInFrame.load(std::memory_order_relaxed));
+    ResetFrame();
+    InitializePersistentJob(mFrameRoot.get(), nullptr, nullptr);
+    mFrameBusyStart.clear();
+    for (const Worker * worker : AllWorkers()) mFrameBusyStart.push_back(worker->mBusyNanoseconds.load(std::memory_order_relaxed));
+    mNumDeferredJobs.store(0, std::memory_order_relaxed);
+    mFrameBudget.store(budgetNanoseconds, std::memory_order_relaxed);
+    mFrameStart.store(TraceBuffer::Now(), std::memory_order_relaxed);
+    mIsInFrame.store(true, std::memory_order_release);
+
+    std::vector<Job *> deferredJobs;
+    {
+        std::lock_guard<std::mutex> lock(mDeferredJobsMutex);
+        deferredJobs.swap(mDeferredJobs);
+    }
+    for (Job * job : deferredJobs) {
+        // put off once, a job that keeps missing the budget would never run otherwise
+        job->flags &= static_cast<uint8_t>(~jobFlagDeferrable);
+        job->parent = mFrameRoot.get();
+        mFrameRoot->unfinishedJobs++;
+    }
+    ScheduleBatch(deferredJobs.data(), deferredJobs.size());
+}
+
+FrameStats ThreadPool::EndFrame()
+{
+    assert(mIsInFrame.load(std::memory_order_relaxed));
+    // let go of the root's own count, it completes with the last job of the frame
+    Job * root = mFrameRoot.get();
+    Finish(root);
+    Wait(root);
+    // the next `BeginFrame()` must not race the last one out
+    WaitForRelease(root);
+
+    FrameStats stats;
+    stats.frame = Frame();
+    stats.budgetNanoseconds = mFrameBudget.load(std::memory_order_relaxed);
+    stats.durationNanoseconds = TraceBuffer::Now() - mFrameStart.load(std::memory_order_relaxed);
+    if (stats.budgetNanoseconds) stats.overrunNanoseconds = std::max<int64_t>(stats.durationNanoseconds - stats.budgetNanoseconds, 0);
+    stats.jobsDeferred = mNumDeferredJobs.load(std::memory_order_relaxed);
+    mIsInFrame.store(false, std::memory_order_release);
+
+    const std::vector<const Worker *> workers = AllWorkers();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        const Worker * worker = workers[i];
+        if (worker->mFramePathFrame.load(std::memory_order_relaxed) == stats.frame) {
+            stats.criticalPathNanoseconds = std::max(stats.criticalPathNanoseconds, worker->mFramePath.load(std::memory_order_relaxed));
+        }
+        const int64_t busy = worker->mBusyNanoseconds.load(std::memory_order_relaxed) - mFrameBusyStart[i];
+        stats.busyFractions.push_back(stats.durationNanoseconds ? static_cast<double>(busy) / static_cast<double>(stats.durationNanoseconds) : 0.0);
+    }
+    return stats;
+}
+
+Job * ThreadPool::CreateFrameJob(JobFunction function, void * data) { return CreateJobAsChild(mFrameRoot.get(), function, data); }
+
+void ThreadPool::ScheduleNextFrame(Job * job)
+{
+    assert(job && !job->parent);
+    std::lock_guard<std::mutex> lock(mDeferredJobsMutex);
+    mDeferredJobs.push_back(job);
+}
+
+void ThreadPool::SetDeferrable(Job * job) { job->flags |= jobFlagDeferrable; }
+
+bool ThreadPool::DeferIfOverBudget(Job * job)
+{
+    // jobs further down belong to the work of a frame job that has already started
+    const int64_t budget = mFrameBudget.load(std::memory_order_relaxed);
+    if (!budget || job->parent != mFrameRoot.get()) return false;
+    if ((TraceBuffer::Now() - mFrameStart.load(std::memory_order_relaxed)) * 100 < budget * mConfig.frameShedPercent) return false;
+
+    job->parent = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mDeferredJobsMutex);
+        mDeferredJobs.push_back(job);
+    }
+    mNumDeferredJobs.fetch_add(1, std::memory_order_relaxed);
+    Finish(mFrameRoot.get());
+    return true;
 }
 
-#pragma clang diagnostic pop
+int64_t ThreadPool::FramePathOf(const Worker * worker) const
+{
+    // outside of any job the chain is whatever the thread did since the frame began
+    const int64_t now = TraceBuffer::Now();
+    if (worker && worker->mExecuteDepth) return worker->mJobPath + (now - worker->mJobStart);
+    return now - mFrameStart.load(std::memory_order_relaxed);
+}
 
+void ThreadPool::RecordFramePath(Worker * worker, const int64_t path)
+{
+    const uint64_t frame = Frame();
+    if (worker->mFramePathFrame.load(std::memory_order_relaxed) != frame) {
+        worker->mFramePath.store(path, std::memory_order_relaxed);
+        worker->mFramePathFrame.store(frame, std::memory_order_relaxed);
+    } else if (path > worker->mFramePath.load(std::memory_order_relaxed)) {
+        worker->mFramePath.store(path, std::memory_order_relaxed);
+    }
+}
 
 void ThreadPool::Wait(Job * job)
 {
-    // wait until the job has completed. in the meantime, work on any other pJob.
-    while (!HasJobCompleted(job)) {
-        Job * nextJob = GetJob();
-        if (nextJob) { Execute(nextJob); }
+    Worker * worker = FindWorker();
+    Trace(worker, TraceEventType::WaitBegin);
+    if (worker && worker->mCurrentFiber) {
+        WaitOnFiber(worker, job);
+    } else {
+        // wait until the job has completed. in the meantime, work on any other pJob.
+        WaitFor([this, job]() { return HasJobCompleted(job); });
     }
+    Trace(worker, TraceEventType::WaitEnd);
 }
 
 Worker * ThreadPool::FindWorker()
@@ -97,7 +594,8 @@ Worker * ThreadPool::FindWorker()
     const auto threadId = std::this_thread::get_id();
     if (threadId == mainThreadId) { return mMainWorker.get(); }
 
-    return localWorker;
+    // the thread might work for an other pool
+    return localWorker && localWorker->mThreadPool == this ? localWorker : nullptr;
 }
 
 Job * ThreadPool::GetJob()
@@ -106,56 +604,469 @@ Job * ThreadPool::GetJob()
     if (!worker) return nullptr; // Should not happen
 
     Job * job = nullptr;
-    const bool hasJob = worker->mQueue.Pop(job);
-    if (!hasJob) {
-        // this is not a valid job because our own queue is empty, so try stealing from some other queue
-
-        JobQueue * stolenQueue = nullptr;
-        Steal(stolenQueue);
 
-        // avoid steal from ourselves
-        if (stolenQueue == &worker->mQueue) {
-            Yield();
-            return nullptr;
-        }
-
-        Job * stolenJob = nullptr;
-        const bool hasStolenJob = stolenQueue->Pop(stolenJob);
-        if (!hasStolenJob) {
-            // we couldn't steal a job from the other queue either, so we just yield our time slice for now
-            Yield();
-            return nullptr;
-        }
+    // aging: every now and then one of the lower priority lanes, in turns, goes first
+    const uint32_t pickCount = ++worker->mPickCount;
+    if (mConfig.priorityAgingLimit && pickCount % mConfig.priorityAgingLimit == 0) {
+        const size_t boostedLane = 1 + (pickCount / mConfig.priorityAgingLimit) % (priorityCount - 1);
+        if (worker->mQueues[boostedLane].Pop(job)) return job;
+        if ((job = Steal(worker, boostedLane))) return job;
+    }
 
-        return stolenJob;
+    if (worker->mQueues[highPriorityLane].Pop(job)) return job;
+    // high priority work of the other workers goes before our own lower priority work
+    if ((job = StealHighPriority(worker))) return job;
+    for (size_t lane = highPriorityLane + 1; lane < priorityCount; ++lane) {
+        if (worker->mQueues[lane].Pop(job)) return job;
     }
 
-    return job;
+    // this is not a valid job because our own queues are empty, so try the spilled jobs and stealing from the other queues
+    // this returns nullptr if we couldn't steal a job from any other queue either, the caller decides how to idle
+    for (size_t lane = 0; lane < priorityCount; ++lane) {
+        if (mInjected[lane].Pop(job)) return job;
+        if (mOverflow[lane].Pop(job)) return job;
+        if ((job = Steal(worker, lane))) return job;
+    }
+    return nullptr;
 }
 
 void ThreadPool::Execute(Job * job)
 {
+    Worker * worker = FindWorker();
+    if (worker && mIsInFrame.load(std::memory_order_relaxed)) {
+        ExecuteInFrame(worker, job);
+        return;
+    }
+    if (worker) JOBSYSTEM_COUNT(worker, jobsExecuted, 1);
+    Trace(worker, TraceEventType::JobBegin, *job);
     (job->function)(job, job->data);
+    // the job may be released by Finish(), record it before
+    Trace(worker, TraceEventType::JobEnd, *job);
     Finish(job);
 }
 
+void ThreadPool::ExecuteInFrame(Worker * worker, Job * job)
+{
+    if ((job->flags & jobFlagDeferrable) && DeferIfOverBudget(job)) return;
+
+    // a job executed within a `Wait()` starts a chain of its own, the waiting one carries on afterwards
+    const int64_t outerPath = worker->mJobPath;
+    const int64_t outerStart = worker->mJobStart;
+    const int64_t start = TraceBuffer::Now();
+    worker->mJobPath = job->framePath;
+    worker->mJobStart = start;
+    ++worker->mExecuteDepth;
+
+    JOBSYSTEM_COUNT(worker, jobsExecuted, 1);
+    Trace(worker, TraceEventType::JobBegin, *job);
+    (job->function)(job, job->data);
+    Trace(worker, TraceEventType::JobEnd, *job);
+
+    const int64_t end = TraceBuffer::Now();
+    RecordFramePath(worker, worker->mJobPath + (end - start));
+    // nested jobs are part of the outermost one's time already
+    if (worker->mExecuteDepth == 1) worker->mBusyNanoseconds.store(worker->mBusyNanoseconds.load(std::memory_order_relaxed) + (end - start), std::memory_order_relaxed);
+    // continuations scheduled by Finish() carry on this chain
+    Finish(job);
+    --worker->mExecuteDepth;
+    worker->mJobPath = outerPath;
+    worker->mJobStart = outerStart;
+}
+
 void ThreadPool::Finish(Job * job)
 {
-    job->unfinishedJobs--;
-    auto unfinishedJobs = job->unfinishedJobs.load(std::memory_order_relaxed);
+    // only the thread that takes the counter to zero may touch the job afterwards
+    const auto unfinishedJobs = job->unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) - 1;
     if (unfinishedJobs == 0) {
-        if (job->parent) { Finish(job->parent); }
-        Deallocate(job);
+        // closing the continuations releases a persistent job, see `WaitForRelease()`; it may be initialized again right after
+        Job * parent = job->parent;
+        const bool isPersistent = (job->flags & jobFlagPersistent) != 0;
+        Job * continuation = job->continuations.exchange(closedContinuations, std::memory_order_acq_rel);
+
+        if (parent) { Finish(parent); }
+        if (!isPersistent) {
+            if (job->destructor) { (job->destructor)(job); }
+            Deallocate(job);
+        }
+
+        // these go into our own queue; read the link first, a scheduled job might be stolen and released right away
+        while (continuation) {
+            Job * next = continuation->nextContinuation;
+            RunContinuation(continuation);
+            continuation = next;
+        }
     }
 }
 
 void ThreadPool::ThreadPool::Yield() NOEXCEPT { std::this_thread::yield(); }
 
+Job * ThreadPool::Idle(Worker * worker, const uint32_t idleRounds)
+{
+    if (idleRounds == 0) {
+        Trace(worker, TraceEventType::IdleBegin);
+        worker->mIdleSince = std::chrono::steady_clock::now().time_since_epoch().count();
+    } else if (mConfig.elasticWorkers) {
+        const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+        const auto retireAfter = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds(mConfig.retireAfterMicroseconds));
+        if (now - worker->mIdleSince > retireAfter.count() && Retire(worker)) {
+            // back from retirement, the idle time starts over
+            worker->mIdleSince = std::chrono::steady_clock::now().time_since_epoch().count();
+            return nullptr;
+        }
+    }
+    switch (mConfig.idlePolicy) {
+        case IdlePolicy::Spin:
+            JOBSYSTEM_COUNT(worker, spins, 1);
+            CPU_PAUSE();
+            return nullptr;
+        case IdlePolicy::Yield:
+            JOBSYSTEM_COUNT(worker, yields, 1);
+            Yield();
+            return nullptr;
+        case IdlePolicy::Adaptive:
+            if (idleRounds < mConfig.spinCount) {
+                JOBSYSTEM_COUNT(worker, spins, 1);
+                CPU_PAUSE();
+            } else if (idleRounds - mConfig.spinCount < mConfig.yieldCount) {
+                JOBSYSTEM_COUNT(worker, yields, 1);
+                Yield();
+            } else {
+                return Park(worker);
+            }
+            return nullptr;
+    }
+    return nullptr;
+}
+
+void ThreadPool::EndIdle(Worker * worker)
+{
+    Trace(worker, TraceEventType::IdleEnd);
+#if JOBSYSTEM_STATS
+    const int64_t idleTime = std::chrono::steady_clock::now().time_since_epoch().count() - worker->mIdleSince;
+    JOBSYSTEM_COUNT(worker, idleNanoseconds, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::duration(idleTime)).count()));
+#endif
+}
+
+Job * ThreadPool::Park(Worker * worker)
+{
+    const uint32_t epoch = mSleepers.PrepareWait();
+
+    // re-check after announcing ourselves, any job scheduled from now on will wake us up
+    Job * job = worker->mIsTerminated ? nullptr : GetJob();
+    if (job || worker->mIsTerminated) {
+        mSleepers.CancelWait();
+        return job;
+    }
+
+    JOBSYSTEM_COUNT(worker, parks, 1);
+    if (mConfig.elasticWorkers) {
+        // wake up in time to retire
+        mSleepers.CommitWait(epoch, static_cast<int64_t>(mConfig.retireAfterMicroseconds) * 1000);
+    } else {
+        mSleepers.CommitWait(epoch);
+    }
+    return nullptr;
+}
+
 bool ThreadPool::HasJobCompleted(const Job * job)
 {
-    const auto unfinishedJobs = job->unfinishedJobs.load(std::memory_order_relaxed);
+    const auto unfinishedJobs = job->unfinishedJobs.load(std::memory_order_acquire);
     return unfinishedJobs == 0;
 }
 
+ThreadPoolStats ThreadPool::GetStats() const
+{
+    ThreadPoolStats stats;
+#if JOBSYSTEM_STATS
+    for (const Worker * worker : AllWorkers()) {
+        const WorkerCounters & counters = worker->mCounters;
+        WorkerStats snapshot;
+        snapshot.jobsScheduled = counters.jobsScheduled.Load();
+        snapshot.jobsExecuted = counters.jobsExecuted.Load();
+        snapshot.stealAttempts = counters.stealAttempts.Load();
+        snapshot.stealSuccesses = counters.stealSuccesses.Load();
+        snapshot.failedPushes = counters.failedPushes.Load();
+        snapshot.queueHighWater = counters.queueHighWater.Load();
+        snapshot.spins = counters.spins.Load();
+        snapshot.yields = counters.yields.Load();
+        snapshot.parks = counters.parks.Load();
+        snapshot.idleNanoseconds = counters.idleNanoseconds.Load();
+        snapshot.retirements = counters.retirements.Load();
+        stats.workers.push_back(snapshot);
+
+        WorkerStats & total = stats.total;
+        total.jobsScheduled += snapshot.jobsScheduled;
+        total.jobsExecuted += snapshot.jobsExecuted;
+        total.stealAttempts += snapshot.stealAttempts;
+        total.stealSuccesses += snapshot.stealSuccesses;
+        total.failedPushes += snapshot.failedPushes;
+        total.queueHighWater = std::max(total.queueHighWater, snapshot.queueHighWater);
+        total.spins += snapshot.spins;
+        total.yields += snapshot.yields;
+        total.parks += snapshot.parks;
+        total.idleNanoseconds += snapshot.idleNanoseconds;
+        total.retirements += snapshot.retirements;
+    }
+#endif
+    return stats;
+}
+
+bool ThreadPool::RegisterExternalThread()
+{
+    // one worker per thread at a time, even across pools
+    if (localWorker || FindWorker()) return false;
+    for (auto & worker : mExternalWorkers) {
+        bool isClaimed = false;
+        if (worker->mIsClaimed.compare_exchange_strong(isClaimed, true, std::memory_order_acquire)) {
+            localWorker = worker.get();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::UnregisterExternalThread()
+{
+    Worker * worker = FindWorker();
+    assert(worker && worker->mIsClaimed.load(std::memory_order_relaxed));
+    localWorker = nullptr;
+    // hands the queues and the job pool over to the next thread that claims it
+    worker->mIsClaimed.store(false, std::memory_order_release);
+}
+
+std::vector<const Worker *> ThreadPool::AllWorkers() const
+{
+    std::vector<const Worker *> workers;
+    for (const auto & worker : mWorkers) workers.push_back(worker.get());
+    workers.push_back(mMainWorker.get());
+    for (const auto & worker : mExternalWorkers) workers.push_back(worker.get());
+    return workers;
+}
+
+uint16_t ThreadPool::RegisterTraceLabel(const char * label)
+{
+    std::lock_guard<std::mutex> lock(mTraceLabelsMutex);
+    assert(mTraceLabels.size() < UINT16_MAX);
+    mTraceLabels.push_back(label);
+    return static_cast<uint16_t>(mTraceLabels.size());
+}
+
+void ThreadPool::SetTraceLabel(Job * job, uint16_t label) { job->label = label; }
+
+namespace
+{
+    void WriteJsonString(FILE * file, const char * text)
+    {
+        std::fputc('"', file);
+        for (const char * c = text; *c; ++c) {
+            if (*c == '"' || *c == '\\') {
+                std::fputc('\\', file);
+                std::fputc(*c, file);
+            } else if (static_cast<unsigned char>(*c) < 0x20) {
+                std::fprintf(file, "\\u%04x", static_cast<unsigned>(*c));
+            } else {
+                std::fputc(*c, file);
+            }
+        }
+        std::fputc('"', file);
+    }
+} // namespace
+
+bool ThreadPool::DumpTrace(const std::string & path) const
+{
+    FILE * file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+
+    std::vector<const char *> labels;
+    {
+        std::lock_guard<std::mutex> lock(mTraceLabelsMutex);
+        labels = mTraceLabels;
+    }
+
+    const std::vector<const Worker *> workers = AllWorkers();
+
+    // Chrome trace event format, one track per worker; durations are begin/end pairs, steals are instants
+    std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool isFirst = true;
+    for (size_t tid = 0; tid < workers.size(); ++tid) {
+        std::string threadName = "Worker " + std::to_string(tid);
+        if (workers[tid] == mMainWorker.get()) threadName = "Main thread";
+        if (tid > mNumWorkers) threadName = "External thread " + std::to_string(tid - mNumWorkers - 1);
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}", isFirst ? "" : ",\n", tid, threadName.c_str());
+        isFirst = false;
+        if (!workers[tid]->mTrace) continue;
+
+        // the ring may have lost the begin of the oldest events, skip ends without a begin
+        uint32_t depth = 0;
+        for (const TraceEvent & event : workers[tid]->mTrace->Snapshot()) {
+            const char * phase = "i";
+            const char * category = "job";
+            switch (event.type) {
+                case TraceEventType::JobBegin: phase = "B"; break;
+                case TraceEventType::JobEnd: phase = "E"; break;
+                case TraceEventType::WaitBegin: phase = "B", category = "wait"; break;
+                case TraceEventType::WaitEnd: phase = "E", category = "wait"; break;
+                case TraceEventType::IdleBegin: phase = "B", category = "idle"; break;
+                case TraceEventType::IdleEnd: phase = "E", category = "idle"; break;
+                case TraceEventType::Steal: phase = "i", category = "steal"; break;
+            }
+            if (*phase == 'B') ++depth;
+            if (*phase == 'E') {
+                if (depth == 0) continue;
+                --depth;
+            }
+
+            std::fprintf(file, ",\n{\"ph\":\"%s\",\"cat\":\"%s\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"name\":", phase, category, tid,
+                         static_cast<double>(event.timestamp - mTraceStart) / 1000.);
+            if (event.label && event.label <= labels.size()) {
+                WriteJsonString(file, labels[event.label - 1]);
+            } else if (event.function) {
+                std::fprintf(file, "\"job 0x%llx\"", static_cast<unsigned long long>(event.function));
+            } else {
+                WriteJsonString(file, category);
+            }
+            if (*phase == 'i') std::fprintf(file, ",\"s\":\"t\"");
+            std::fputc('}', file);
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+void ThreadPool::RunContinuation(Job * continuation)
+{
+    if (!(continuation->flags & jobFlagResumeFiber)) {
+        Schedule(continuation);
+        return;
+    }
+
+    // the owner may resume the fiber and reuse the node as soon as it is pushed, so nothing is touched after the CAS
+    auto * fiber = static_cast<WorkerFiber *>(continuation->data);
+    Worker * owner = fiber->worker;
+    WorkerFiber * head = owner->mReadyFibers.load(std::memory_order_relaxed);
+    do {
+        fiber->nextReady = head;
+    } while (!owner->mReadyFibers.compare_exchange_weak(head, fiber, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// ------------------------------------------------------------------------------------------------------------------
+// Fibers
+// Every thread runs the same loop on whichever of its fibers is current. A `Wait()` suspends the current fiber and the loop
+// carries on on a free one; once the job to wait for has finished, `Finish()` pushes the waiting fiber back to its worker,
+// whose loop parks itself and switches to it. Fibers never migrate, so thread_locals stay valid across a `Wait()`.
+
+void ThreadPool::FiberMain(void * worker)
+{
+    auto * owner = static_cast<Worker *>(worker);
+    owner->mThreadPool->RunFibers(owner);
+    // only the thread's own stack returns from the loop
+    std::abort();
+}
+
+void ThreadPool::InitializeFibers(Worker * worker)
+{
+    worker->mThreadFiber.worker = worker;
+    worker->mCurrentFiber = &worker->mThreadFiber;
+    for (uint32_t i = 0; i < mConfig.fibersPerWorker; ++i) {
+        worker->mFibers.push_back(std::make_unique<WorkerFiber>(mConfig.fiberStackSize, &FiberMain, worker));
+        worker->mFreeFibers.push_back(worker->mFibers.back().get());
+    }
+}
+
+void ThreadPool::RunFibers(Worker * worker)
+{
+    uint32_t idleRounds = 0;
+    for (;;) {
+        if (worker->mIsTerminated && worker->mNumSuspendedFibers == 0) {
+            if (worker->mCurrentFiber == &worker->mThreadFiber) return;
+            // the thread's own stack is parked in here as well, let it return
+            SwitchFiber(worker, &worker->mThreadFiber);
+        }
+
+        WorkerFiber * readyFiber = PopReadyFiber(worker);
+        if (readyFiber) {
+            --worker->mNumSuspendedFibers;
+            // park this one, it carries on from here once a `Wait()` needs a free fiber
+            worker->mFreeFibers.push_back(worker->mCurrentFiber);
+            SwitchFiber(worker, readyFiber);
+            if (idleRounds) EndIdle(worker);
+            idleRounds = 0;
+            continue;
+        }
+
+        Job * job = GetJob();
+        if (!job) {
+            // nobody would wake us when a waiting fiber gets ready, so never park while there are any
+            if (worker->mNumSuspendedFibers) {
+                Yield();
+            } else {
+                job = Idle(worker, idleRounds++);
+            }
+        }
+        if (job) {
+            if (idleRounds) EndIdle(worker);
+            Execute(job);
+            idleRounds = 0;
+        }
+    }
+}
+
+void ThreadPool::WaitOnFiber(Worker * worker, Job * job)
+{
+    if (HasJobCompleted(job)) return;
+    if (worker->mFreeFibers.empty()) {
+        // every fiber waits already, help out on this stack like without fibers
+        WaitFor([this, job]() { return HasJobCompleted(job); });
+        return;
+    }
+
+    WorkerFiber * waitingFiber = worker->mCurrentFiber;
+    Job * resumeNode = &waitingFiber->resumeNode;
+    InitializePersistentJob(resumeNode, nullptr, waitingFiber);
+    resumeNode->flags |= jobFlagResumeFiber;
+
+    // even if `job` finishes right away, only this thread resumes the fiber and only after it has switched away
+    ++worker->mNumSuspendedFibers;
+    AddContinuation(job, resumeNode);
+
+    WorkerFiber * nextFiber = worker->mFreeFibers.back();
+    worker->mFreeFibers.pop_back();
+    SwitchFiber(worker, nextFiber);
+}
+
+void ThreadPool::SwitchFiber(Worker * worker, WorkerFiber * next)
+{
+    WorkerFiber * current = worker->mCurrentFiber;
+    worker->mCurrentFiber = next;
+    current->fiber.SwitchTo(next->fiber);
+}
+
+bool ThreadPool::ResumeReadyFiber()
+{
+    Worker * worker = FindWorker();
+    if (!worker || !worker->mCurrentFiber) return false;
+
+    WorkerFiber * readyFiber = PopReadyFiber(worker);
+    if (!readyFiber) return false;
+
+    // whoever we wait for might be the fiber that got ready; stay ready ourselves, the loop switches back to us
+    WorkerFiber * current = worker->mCurrentFiber;
+    current->nextReady = worker->mLocalReadyFibers;
+    worker->mLocalReadyFibers = current;
+    SwitchFiber(worker, readyFiber);
+    return true;
+}
+
+WorkerFiber * ThreadPool::PopReadyFiber(Worker * worker)
+{
+    if (!worker->mLocalReadyFibers && worker->mReadyFibers.load(std::memory_order_relaxed)) {
+        worker->mLocalReadyFibers = worker->mReadyFibers.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    WorkerFiber * fiber = worker->mLocalReadyFibers;
+    if (fiber) { worker->mLocalReadyFibers = fiber->nextReady; }
+    return fiber;
+}
+
 // ------------------------------------------------------------------------------------------------------------------
 
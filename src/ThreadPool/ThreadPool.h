@@ -1,12 +1,28 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <utility>
 
-#include "BoundedMpmcQueue.h"
+#include "WorkStealingQueue.h"
+#include "BoundedQueue.h"
+#include "SegmentedQueue.h"
+#include "EventCount.h"
 #include "MemoryPoolAllocator.h"
+#include "FrameArena.h"
+#include "JobAllocator.h"
+#include "Fiber.h"
+#include "CpuTopology.h"
+#include "ThreadPoolStats.h"
+#include "TraceBuffer.h"
 #include "ThreadPlatform.h"
 
 namespace JobSystem
@@ -15,14 +31,108 @@ namespace JobSystem
     {
         struct Job;
         struct Worker;
+        struct WorkerFiber;
 
         typedef void (*JobFunction)(Job *, void *);
+        typedef void (*JobDestructor)(Job *);
 
-        typedef BoundedMpmcQueue<Job *> JobQueue;
+        typedef WorkStealingQueue<Job *> JobQueue;
 
         constexpr size_t cachelineSize = 64;
         typedef char CachelinePadType[cachelineSize];
 
+        // a job takes two whole cache lines, whatever the header does not use is inline payload
+        constexpr size_t jobSize = 2 * cachelineSize;
+        constexpr size_t jobPayloadSize = 64;
+
+        /**
+         * Every worker has one queue per priority
+         */
+        enum class Priority : uint8_t
+        {
+            High = 0,
+            Normal,
+            Low
+        };
+        constexpr size_t priorityCount = 3;
+
+        // a worker that is not pinned to any cpu
+        constexpr size_t noCpu = SIZE_MAX;
+
+        // the job is owned by the caller and never released by the pool, see `ThreadPool::InitializePersistentJob()`
+        constexpr uint8_t jobFlagPersistent = 1 << 0;
+        // a continuation that hands a suspended fiber back to its worker instead of being scheduled, see `ThreadPoolConfig::useFibers`
+        constexpr uint8_t jobFlagResumeFiber = 1 << 1;
+        // may be moved to the next frame when the current one runs out of budget, see `ThreadPool::BeginFrame()`
+        constexpr uint8_t jobFlagDeferrable = 1 << 2;
+
+        /**
+         * What a worker does when it could not find any job
+         */
+        enum class IdlePolicy
+        {
+            Spin,    // busy-wait with pause instructions, lowest latency, burns the core
+            Yield,   // give up the time slice, still burns the core when nobody else wants it
+            Adaptive // spin, then yield, then park until new work gets scheduled
+        };
+
+        /**
+         * What `Schedule()` does when the worker's queue is full
+         */
+        enum class OverflowPolicy
+        {
+            Spill,        // into a shared unbounded queue the workers drain before stealing
+            RunInline,    // execute the job right away on the calling thread
+            Backpressure // execute other jobs on the calling thread until there is room
+        };
+
+        struct ThreadPoolConfig
+        {
+            IdlePolicy idlePolicy = IdlePolicy::Adaptive;
+            uint32_t spinCount = 64;  // idle rounds spent spinning before yielding
+            uint32_t yieldCount = 16; // idle rounds spent yielding before parking
+            // every this many picks a lower priority queue is served first, so background work cannot starve
+            uint32_t priorityAgingLimit = 32;
+            OverflowPolicy overflowPolicy = OverflowPolicy::Spill;
+            // a thief takes up to half of what its victim has, at most this many jobs; 1 steals one job at a time
+            uint32_t stealBatchLimit = 8;
+
+            // run jobs on fibers, so `Wait()` suspends the waiting job instead of executing other jobs on top of its stack
+            // Linux/x86-64 only, ignored elsewhere. Jobs then run on `fiberStackSize` stacks; threads outside the pool still wait on their own stack.
+            bool useFibers = false;
+            uint32_t fibersPerWorker = 128; // once all of them wait, `Wait()` falls back to executing jobs on the current stack
+            size_t fiberStackSize = 64 * 1024;
+
+            // pin the workers to cpus, one per physical core first, and let them steal from the closest ones first:
+            // SMT sibling, shared cache, same NUMA node, then the rest (see `CpuTopology`)
+            bool pinThreads = false;
+
+            // events every worker keeps for `ThreadPool::DumpTrace()`, the oldest get overwritten; 0 turns tracing off
+            size_t traceEventsPerWorker = 0;
+
+            // workers for threads outside of the pool, see `ThreadPool::RegisterExternalThread()`
+            uint32_t externalThreadSlots = 0;
+
+            // the shared job pool grows by `ThreadPool::maxJobCount` jobs at a time, up to this many times, before `CreateJob()`
+            // has to wait for jobs to finish; every job pool takes its memory from `jobPoolBacking`
+            uint32_t maxSharedJobChunks = 16;
+            PoolBacking jobPoolBacking = PoolBacking::Heap;
+
+            // every worker has two frame arenas, see `ThreadPool::AllocateFrame()`; they grow by blocks of this many bytes, on first use
+            size_t frameArenaBlockSize = 64 * 1024;
+
+            // elastic pool: a worker that found nothing to do for `retireAfterMicroseconds` retires, down to `minWorkers`.
+            // It hands over whatever is left in its queues and sleeps until a queue backs up beyond `growQueueDepth` jobs.
+            // The threads are started up front either way, a retired one just does not take part in scheduling.
+            bool elasticWorkers = false;
+            uint32_t minWorkers = 1; // at least one
+            uint32_t retireAfterMicroseconds = 100000;
+            uint32_t growQueueDepth = 16;
+
+            // once this much of a frame's budget has passed, deferrable jobs of the frame move to the next one, see `ThreadPool::BeginFrame()`
+            uint32_t frameShedPercent = 80;
+        };
+
         /**
          * Threadpool implementation with job stealing
          * Impl. Based on Molecoolar Matters
@@ -34,7 +144,7 @@ namespace JobSystem
         public:
             static const size_t maxJobCount = 4096;
 
-            explicit ThreadPool(size_t numThreads);
+            explicit ThreadPool(size_t numThreads, const ThreadPoolConfig & config = ThreadPoolConfig());
             virtual ~ThreadPool();
 
 
@@ -42,55 +152,349 @@ namespace JobSystem
             ThreadPool & operator=(const ThreadPool &) = delete;
 
             size_t NumWorkers() const { return mNumWorkers; }
+            // workers not retired, see `ThreadPoolConfig::elasticWorkers`
+            size_t NumActiveWorkers() const { return mNumActiveWorkers.load(std::memory_order_relaxed); }
 
             Job * CreateJob(JobFunction function, void * data);
             Job * CreateJobAsChild(Job * parent, JobFunction function, void * data);
 
+            /**
+             * Creates a job from any callable taking either `(Job *)` or nothing
+             * Callables up to `jobPayloadSize` bytes are stored inside the job, bigger ones on the heap.
+             * The callable is destroyed when the job is released, that is after all of its children have finished.
+             */
+            template<typename FunctionType> Job * CreateJob(FunctionType && function);
+            template<typename FunctionType> Job * CreateJobAsChild(Job * parent, FunctionType && function);
+
+            // children inherit the priority of their parent, other jobs are `Priority::Normal` unless scheduled otherwise
+            // threads without a worker can schedule too, their jobs go through a shared injection queue the workers poll
             void Schedule(Job * job);
+            void Schedule(Job * job, Priority priority);
+            // runs of jobs with the same priority go into the queue at once, with a single publishing store
+            void ScheduleBatch(Job * const * jobs, size_t numJobs);
             void Wait(Job * job);
 
+            // executes other jobs on the calling thread until `isDone()` returns true
+            template<typename PredicateType> void WaitFor(PredicateType && isDone);
+
+            /**
+             * Schedules `continuation` onto the finishing worker once `antecedent` and all of its children have finished
+             * `continuation` must be created but not scheduled. Add continuations before `antecedent` is scheduled, or from within it:
+             * once it has finished the job is released. If it is just finishing, the continuation gets scheduled right away.
+             */
+            void AddContinuation(Job * antecedent, Job * continuation);
+
+            /**
+             * Lends one of the `ThreadPoolConfig::externalThreadSlots` workers to the calling thread, so it executes jobs in `Wait()`
+             * and schedules into a queue of its own. Returns false if all of them are taken, or the thread has a worker already.
+             * Jobs still queued on unregistering are left for the others to steal.
+             */
+            bool RegisterExternalThread();
+            void UnregisterExternalThread();
+
+            /**
+             * (Re)initializes a job that lives in the caller's memory, so it can be scheduled again and again without allocation
+             * It is never released by the pool, `parent` is not touched, the caller sets up its counter.
+             */
+            void InitializePersistentJob(Job * job, JobFunction function, void * data, Job * parent = nullptr);
+            // the thread that completed a persistent job may still be closing it after `Wait()` returned; wait for it before initializing it again
+            void WaitForRelease(const Job * job);
+
+            /**
+             * Scratch memory for the current frame from the calling worker's arena, a pointer bump that is never freed one by one
+             * It stays valid through the next frame too, so the jobs of one frame can still finish while the next one allocates.
+             * `ResetFrame()` starts a new frame: whatever was allocated two frames ago is gone, its arenas get reused.
+             * Threads without a worker share an arena behind a lock.
+             */
+            void * AllocateFrame(size_t size, size_t alignment = alignof(std::max_align_t));
+            void ResetFrame();
+            uint64_t Frame() const { return mFrame.load(std::memory_order_acquire); }
+
+            /**
+             * Frame loop: one thread at a time begins a frame, creates its jobs with `CreateFrameJob()`, and ends it
+             * `BeginFrame()` starts a new frame (see `ResetFrame()`) and schedules the jobs put off by the previous one. Once more than
+             * `ThreadPoolConfig::frameShedPercent` of `budgetNanoseconds` has passed, frame jobs marked with `SetDeferrable()` that did not
+             * start yet are put off to the next frame instead, they will not be put off twice. A budget of 0 never sheds.
+             * `EndFrame()` executes jobs until every job of the frame has finished, and tells how the frame went.
+             */
+            void BeginFrame(int64_t budgetNanoseconds = 0);
+            FrameStats EndFrame();
+            Job * CreateFrameJob(JobFunction function, void * data);
+            template<typename FunctionType> Job * CreateFrameJob(FunctionType && function);
+            // runs `job`, created but not scheduled and without a parent, as part of the next frame
+            void ScheduleNextFrame(Job * job);
+            static void SetDeferrable(Job * job);
+
+            /**
+             * Sums up the counters of every worker, empty if they are compiled out (`ThreadPoolStats::isEnabled`)
+             * Can be called from any thread at any time, every counter is consistent in itself but not with the others.
+             */
+            ThreadPoolStats GetStats() const;
+
+            /**
+             * Tracing, see `ThreadPoolConfig::traceEventsPerWorker`
+             * Jobs show up by their function address, or by a label: register it once, it has to outlive the pool, then set it on the jobs.
+             * `DumpTrace()` writes Chrome trace event json (chrome://tracing, ui.perfetto.dev), it can be called while the pool runs.
+             */
+            uint16_t RegisterTraceLabel(const char * label);
+            static void SetTraceLabel(Job * job, uint16_t label);
+            bool DumpTrace(const std::string & path) const;
+
         protected:
             Job * AllocateJob();
             void Deallocate(Job * job);
-            void Steal(JobQueue *& stolenQueue);
+            Job * Steal(Worker * thief, size_t lane);
+            void StealMore(Worker * thief, Worker * victim, size_t lane);
+            Job * StealHighPriority(Worker * thief);
+            void WaitForWorkers();
+            void FindVictims(Worker * thief);
+            // the pool's workers, the main thread's, then the external slots
+            std::vector<const Worker *> AllWorkers() const;
+            void Inject(Job * job);
+            // elastic pool: wakes up a retired worker if a queue holds more than `ThreadPoolConfig::growQueueDepth` jobs
+            void GrowIfBacklogged(size_t queueDepth);
+            // hands the worker's jobs over and sleeps until it is needed again, false if it has to stay
+            bool Retire(Worker * worker);
 
             Worker * FindWorker();
 
             Job * GetJob();
 
             void Execute(Job * job);
+            // `Execute()` while a frame is on, with the accounting for `EndFrame()`
+            void ExecuteInFrame(Worker * worker, Job * job);
             void Finish(Job * job);
+            // puts off a deferrable job of the current frame if the budget is running out
+            bool DeferIfOverBudget(Job * job);
+            // longest chain of job executions that leads up to now on the calling thread, see `FrameStats::criticalPathNanoseconds`
+            int64_t FramePathOf(const Worker * worker) const;
+            void RecordFramePath(Worker * worker, int64_t path);
+
+            template<typename FunctionType> static void StoreFunction(Job * job, FunctionType && function);
 
             void Yield() NOEXCEPT;
+            Job * Idle(Worker * worker, uint32_t idleRounds);
+            Job * Park(Worker * worker);
+            void EndIdle(Worker * worker);
 
             bool HasJobCompleted(const Job * job);
 
+            // schedules the continuation, or hands back the fiber it resumes
+            void RunContinuation(Job * continuation);
+
+            static void FiberMain(void * worker);
+            void InitializeFibers(Worker * worker);
+            void RunFibers(Worker * worker);
+            void WaitOnFiber(Worker * worker, Job * job);
+            // lets a fiber that is done waiting run before the calling one, returns false if there is none or no fibers at all
+            bool ResumeReadyFiber();
+            void SwitchFiber(Worker * worker, WorkerFiber * next);
+            WorkerFiber * PopReadyFiber(Worker * worker);
+
         private:
+            ThreadPoolConfig mConfig;
             size_t mNumWorkers;
             std::vector<std::unique_ptr<Worker>> mWorkers;
             std::unique_ptr<Worker> mMainWorker;
+            std::vector<std::unique_ptr<Worker>> mExternalWorkers;
+            // empty unless the threads get pinned
+            CpuTopology mTopology;
+            std::atomic<size_t> mNumStartedWorkers{ 0 };
+            std::atomic<size_t> mNumActiveWorkers{ 0 };
 
+            int64_t mTraceStart;
+            mutable std::mutex mTraceLabelsMutex;
+            std::vector<const char *> mTraceLabels;
+
+            // jobs created by threads that don't own a worker, and by workers that ran out of their own
             MemoryPoolAllocator mAllocator;
+            // jobs scheduled by threads without a worker; any number of them push, every worker pops
+            // sized at runtime: with the cells inline the three lanes alone would make the pool ~200 KB
+            MpmcQueue<Job *> mInjected[priorityCount] = { MpmcQueue<Job *>(ThreadPool::maxJobCount), MpmcQueue<Job *>(ThreadPool::maxJobCount), MpmcQueue<Job *>(ThreadPool::maxJobCount) };
+            // jobs that did not fit into their queue, see `OverflowPolicy::Spill`
+            SegmentedQueue<Job *> mOverflow[priorityCount];
+
+            std::atomic<uint64_t> mFrame{ 0 };
+            // for threads without a worker
+            std::mutex mFrameArenaMutex;
+            FrameArena mSharedFrameArenas[2];
+            uint64_t mSharedArenaFrames[2] = {};
+
+            // frame loop, see `BeginFrame()`; the root is the parent of every frame job
+            std::unique_ptr<Job> mFrameRoot;
+            std::atomic<bool> mIsInFrame{ false };
+            std::atomic<int64_t> mFrameStart{ 0 };
+            std::atomic<int64_t> mFrameBudget{ 0 };
+            std::atomic<uint64_t> mNumDeferredJobs{ 0 };
+            std::vector<int64_t> mFrameBusyStart; // busy time of every worker as the frame began
+            std::mutex mDeferredJobsMutex;
+            std::vector<Job *> mDeferredJobs; // for the next frame
+
+            EventCount mSleepers;
+            // where the retired workers sleep, apart from the idle ones so scheduling a job does not wake them
+            EventCount mRetiredWorkers;
+
+            // set when a high priority job got scheduled, so workers look for it before their own lower priority work
+            alignas(cachelineSize) std::atomic<bool> mHasHighPriorityJobs{ false };
+            CachelinePadType pad0_{};
 
             std::thread::id mainThreadId;
 
             std::vector<std::thread> mThreads;
         };
 
-        struct Worker
-        {
-            JobQueue mQueue = { ThreadPool::maxJobCount };
-            std::atomic_bool mIsTerminated = false;
-        };
 
-        struct Job
+        struct alignas(cachelineSize) Job
         {
             JobFunction function;
             Job * parent;
             void * data;
+            JobAllocator * allocator; // nullptr if it came from the shared pool
+            JobDestructor destructor; // releases whatever `data` points to, if needed
+            std::atomic<Job *> continuations;  // intrusive list of jobs to schedule once this one has finished
+            union
+            {
+                Job * nextContinuation; // link in the antecedent's `continuations`, until it gets scheduled
+                int64_t framePath;      // from then on, the chain of job executions leading to it, see `ThreadPool::FramePathOf()`
+            };
             std::atomic_char32_t unfinishedJobs;
-            CachelinePadType padding;
+            uint8_t flags;
+            Priority priority;
+            uint16_t label; // for tracing, see `ThreadPool::RegisterTraceLabel()`
+            alignas(std::max_align_t) unsigned char payload[jobPayloadSize];
         };
+
+        static_assert(sizeof(Job) == jobSize, "Update jobPayloadSize to fill up the job");
+
+        /**
+         * A fiber of a worker, it never migrates to an other thread
+         * `resumeNode` is what a waiting fiber adds to the continuations of the job it waits for.
+         */
+        struct WorkerFiber
+        {
+            WorkerFiber() = default;
+            WorkerFiber(size_t stackSize, Fiber::EntryFunction entry, Worker * owner) : fiber(stackSize, entry, owner), worker(owner) {}
+
+            Fiber fiber;
+            Worker * worker = nullptr;
+            WorkerFiber * nextReady = nullptr;
+            Job resumeNode;
+        };
+
+        struct Worker
+        {
+            explicit Worker(ThreadPool * threadPool);
+
+            ThreadPool * const mThreadPool;
+            JobQueue mQueues[priorityCount] = { ThreadPool::maxJobCount, ThreadPool::maxJobCount, ThreadPool::maxJobCount };
+            JobAllocator mJobAllocator;
+            std::atomic_bool mIsTerminated = false;
+            // set by the worker itself, cleared by whoever brings it back, see `ThreadPool::Retire()`
+            std::atomic<bool> mIsRetired{ false };
+            // xorshift state for picking victims, only touched by the owner
+            uint32_t mRandomState = 1;
+            // number of GetJob() calls, drives the priority aging
+            uint32_t mPickCount = 0;
+            // index into the pool's topology, `noCpu` unless pinned
+            size_t mCpuIndex = noCpu;
+            // every other worker, closest first; `mVictimTiers` holds where each distance tier ends
+            std::vector<Worker *> mVictims;
+            std::vector<size_t> mVictimTiers;
+            // external slots only, taken by a registered thread
+            std::atomic<bool> mIsClaimed{ false };
+
+            // owner only, see `ThreadPool::GetStats()`
+            alignas(cachelineSize) WorkerCounters mCounters;
+            int64_t mIdleSince = 0; // steady clock ticks
+            // nullptr unless tracing, see `ThreadPool::DumpTrace()`
+            std::unique_ptr<TraceBuffer> mTrace;
+            // owner only, one per frame parity; each is reset once its owner allocates in a newer frame
+            FrameArena mFrameArenas[2];
+            uint64_t mArenaFrames[2] = {};
+            // frame accounting, see `ThreadPool::EndFrame()`: the job being executed, the chain leading to it and when it started
+            int64_t mJobPath = 0;
+            int64_t mJobStart = 0;
+            uint32_t mExecuteDepth = 0;
+            // written by the owner, read by `EndFrame()`
+            std::atomic<int64_t> mBusyNanoseconds{ 0 };
+            std::atomic<int64_t> mFramePath{ 0 }; // the longest chain it finished in frame `mFramePathFrame`
+            std::atomic<uint64_t> mFramePathFrame{ 0 };
+
+            // fiber mode only, all of these except `mReadyFibers` are touched by the owner only
+            WorkerFiber mThreadFiber;                // the thread's own stack
+            WorkerFiber * mCurrentFiber = nullptr;
+            std::vector<std::unique_ptr<WorkerFiber>> mFibers;
+            std::vector<WorkerFiber *> mFreeFibers; // parked in `RunFibers()`, ready to pick up jobs in place of a waiting one
+            WorkerFiber * mLocalReadyFibers = nullptr;
+            uint32_t mNumSuspendedFibers = 0;
+            // fibers whose job to wait for has finished, pushed by `Finish()` on any thread
+            alignas(cachelineSize) std::atomic<WorkerFiber *> mReadyFibers{ nullptr };
+        };
+
+        // ------------------------------------------------------------------------------------------------------------------
+
+        template<typename FunctionType> void InvokeJobFunction(Job * job, void * data)
+        {
+            FunctionType & function = *static_cast<FunctionType *>(data);
+            if constexpr (std::is_invocable<FunctionType &, Job *>::value) {
+                function(job);
+            } else {
+                function();
+            }
+        }
+
+        template<typename FunctionType> void DestroyInlineJobFunction(Job * job) { static_cast<FunctionType *>(job->data)->~FunctionType(); }
+
+        template<typename FunctionType> void DeleteJobFunction(Job * job) { delete static_cast<FunctionType *>(job->data); }
+
+        template<typename FunctionType> void ThreadPool::StoreFunction(Job * job, FunctionType && function)
+        {
+            typedef typename std::decay<FunctionType>::type StoredType;
+            static_assert(std::is_invocable<StoredType &, Job *>::value || std::is_invocable<StoredType &>::value, "Job functions take (Job *) or nothing");
+
+            job->function = &InvokeJobFunction<StoredType>;
+            if constexpr (sizeof(StoredType) <= jobPayloadSize && alignof(StoredType) <= alignof(std::max_align_t)) {
+                job->data = new (job->payload) StoredType(std::forward<FunctionType>(function));
+                job->destructor = std::is_trivially_destructible<StoredType>::value ? nullptr : &DestroyInlineJobFunction<StoredType>;
+            } else {
+                job->data = new StoredType(std::forward<FunctionType>(function));
+                job->destructor = &DeleteJobFunction<StoredType>;
+            }
+        }
+
+        template<typename FunctionType> Job * ThreadPool::CreateFrameJob(FunctionType && function)
+        {
+            return CreateJobAsChild(mFrameRoot.get(), std::forward<FunctionType>(function));
+        }
+
+        template<typename PredicateType> void ThreadPool::WaitFor(PredicateType && isDone)
+        {
+            while (!isDone()) {
+                if (mConfig.useFibers && ResumeReadyFiber()) continue;
+                Job * nextJob = GetJob();
+                if (nextJob) {
+                    Execute(nextJob);
+                } else {
+                    // nobody would wake us when the job completes, so never park here
+                    Yield();
+                }
+            }
+        }
+
+        template<typename FunctionType> Job * ThreadPool::CreateJob(FunctionType && function)
+        {
+            Job * job = CreateJob(nullptr, nullptr);
+            StoreFunction(job, std::forward<FunctionType>(function));
+            return job;
+        }
+
+        template<typename FunctionType> Job * ThreadPool::CreateJobAsChild(Job * parent, FunctionType && function)
+        {
+            Job * job = CreateJobAsChild(parent, nullptr, nullptr);
+            StoreFunction(job, std::forward<FunctionType>(function));
+            return job;
+        }
+
     } // namespace Internal
 
 
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// per worker counters, see `ThreadPool::GetStats()`; with 0 they are compiled out, CMake option ENABLE_STATS
+#if !defined(JOBSYSTEM_STATS)
+#    define JOBSYSTEM_STATS 1
+#endif
+
+#if JOBSYSTEM_STATS
+#    define JOBSYSTEM_COUNT(worker, counter, amount) (worker)->mCounters.counter.Add(amount)
+#    define JOBSYSTEM_COUNT_MAX(worker, counter, value) (worker)->mCounters.counter.Max(value)
+#else
+#    define JOBSYSTEM_COUNT(worker, counter, amount) ((void)0)
+#    define JOBSYSTEM_COUNT_MAX(worker, counter, value) ((void)0)
+#endif
+
+namespace JobSystem
+{
+    namespace Internal
+    {
+        /**
+         * Counter written by a single thread and read by anyone
+         * A relaxed load and store, no read-modify-write, so updating it costs as much as a plain increment.
+         */
+        class StatCounter
+        {
+        public:
+            void Add(uint64_t amount) noexcept { mValue.store(mValue.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed); }
+            void Max(uint64_t value) noexcept
+            {
+                if (value > mValue.load(std::memory_order_relaxed)) mValue.store(value, std::memory_order_relaxed);
+            }
+            uint64_t Load() const noexcept { return mValue.load(std::memory_order_relaxed); }
+
+        private:
+            std::atomic<uint64_t> mValue{ 0 };
+        };
+
+        /**
+         * Snapshot of one worker, or the sum of all of them
+         */
+        struct WorkerStats
+        {
+            uint64_t jobsScheduled = 0;
+            uint64_t jobsExecuted = 0;
+            uint64_t stealAttempts = 0;  // victim queues looked into
+            uint64_t stealSuccesses = 0;
+            uint64_t failedPushes = 0;   // `Schedule()` found its queue full
+            uint64_t queueHighWater = 0; // most jobs seen in one of its queues, the maximum of all workers in the total
+            uint64_t spins = 0;
+            uint64_t yields = 0;
+            uint64_t parks = 0;
+            uint64_t idleNanoseconds = 0; // from running out of jobs until finding the next one, time spent retired not included
+            uint64_t retirements = 0;     // see `ThreadPoolConfig::elasticWorkers`
+        };
+
+        struct ThreadPoolStats
+        {
+            static constexpr bool isEnabled = JOBSYSTEM_STATS != 0;
+
+            std::vector<WorkerStats> workers; // the pool's workers, the main thread, then the external thread slots
+            WorkerStats total;
+        };
+
+        /**
+         * How a frame went, see `ThreadPool::EndFrame()`
+         */
+        struct FrameStats
+        {
+            uint64_t frame = 0;
+            int64_t budgetNanoseconds = 0;       // 0 if it had none
+            int64_t durationNanoseconds = 0;     // from `BeginFrame()` until its last job finished
+            int64_t overrunNanoseconds = 0;      // past the budget
+            // the longest chain of jobs, each scheduled by the one before, or once it finished; no number of workers gets the frame below this.
+            // Time spent in a `Wait()` counts towards the waiting job, queueing does not.
+            int64_t criticalPathNanoseconds = 0;
+            uint64_t jobsDeferred = 0;           // put off to the next frame to keep the budget
+            std::vector<double> busyFractions;   // of the duration spent executing jobs, in the order of `ThreadPoolStats::workers`
+        };
+
+        // what a worker keeps up to date, kept apart from the fields other threads touch
+        struct WorkerCounters
+        {
+#if JOBSYSTEM_STATS
+            StatCounter jobsScheduled;
+            StatCounter jobsExecuted;
+            StatCounter stealAttempts;
+            StatCounter stealSuccesses;
+            StatCounter failedPushes;
+            StatCounter queueHighWater;
+            StatCounter spins;
+            StatCounter yields;
+            StatCounter parks;
+            StatCounter idleNanoseconds;
+            StatCounter retirements;
+#endif
+        };
+
+    } // namespace Internal
+} // namespace JobSystem
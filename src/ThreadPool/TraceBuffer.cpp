@@ -0,0 +1,36 @@
+#include "TraceBuffer.h"
+
+#include <algorithm>
+
+using namespace JobSystem::Internal;
+
+TraceBuffer::TraceBuffer(size_t capacity)
+{
+    size_t roundedCapacity = 2;
+    while (roundedCapacity < capacity) roundedCapacity *= 2;
+    mSlots = std::make_unique<Slot[]>(roundedCapacity);
+    mMask = roundedCapacity - 1;
+}
+
+std::vector<TraceEvent> TraceBuffer::Snapshot() const
+{
+    const uint64_t capacity = mMask + 1;
+    const uint64_t head = mHead.load(std::memory_order_acquire);
+    const uint64_t first = head > capacity ? head - capacity : 0;
+
+    std::vector<TraceEvent> events;
+    events.reserve(head - first);
+    for (uint64_t index = first; index < head; ++index) {
+        const Slot & slot = mSlots[index & mMask];
+        const uint32_t labelAndType = slot.labelAndType.load(std::memory_order_relaxed);
+        events.push_back({ slot.timestamp.load(std::memory_order_relaxed), slot.function.load(std::memory_order_relaxed), static_cast<uint16_t>(labelAndType >> 8),
+                           static_cast<TraceEventType>(labelAndType & 0xFF) });
+    }
+
+    // pairs with the fence in Record(): if we saw anything of a newer event, we also see that it was announced
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t writing = mWriting.load(std::memory_order_relaxed);
+    const uint64_t firstIntact = writing > capacity ? writing - capacity : 0;
+    if (firstIntact > first) events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(std::min(firstIntact, head) - first));
+    return events;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace JobSystem
+{
+    namespace Internal
+    {
+        enum class TraceEventType : uint8_t
+        {
+            JobBegin,
+            JobEnd,
+            WaitBegin,
+            WaitEnd,
+            IdleBegin,
+            IdleEnd,
+            Steal
+        };
+
+        struct TraceEvent
+        {
+            int64_t timestamp;      // nanoseconds, steady clock
+            uintptr_t function;     // address of the job function, 0 if none
+            uint16_t label;         // see `ThreadPool::RegisterTraceLabel()`, 0 if none
+            TraceEventType type;
+        };
+
+        /**
+         * Fixed size ring of trace events, written by a single thread and read by anyone
+         * Recording is wait-free: a handful of relaxed stores, the oldest events get overwritten.
+         */
+        class TraceBuffer
+        {
+        public:
+            // `capacity` is rounded up to a power of two
+            explicit TraceBuffer(size_t capacity);
+
+            TraceBuffer(const TraceBuffer &) = delete;
+            TraceBuffer & operator=(const TraceBuffer &) = delete;
+
+            // owner thread only
+            void Record(TraceEventType type, uintptr_t function = 0, uint16_t label = 0) noexcept
+            {
+                const uint64_t index = mHead.load(std::memory_order_relaxed);
+                // announce the slot before touching it, so a reader can tell what it might have seen half written
+                mWriting.store(index + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+
+                Slot & slot = mSlots[index & mMask];
+                slot.timestamp.store(Now(), std::memory_order_relaxed);
+                slot.function.store(function, std::memory_order_relaxed);
+                slot.labelAndType.store(static_cast<uint32_t>(label) << 8 | static_cast<uint32_t>(type), std::memory_order_relaxed);
+                mHead.store(index + 1, std::memory_order_release);
+            }
+
+            // any thread; what is still in the buffer, oldest first. Events that might have been overwritten meanwhile are dropped.
+            std::vector<TraceEvent> Snapshot() const;
+
+            size_t Capacity() const { return mMask + 1; }
+
+            static int64_t Now() noexcept
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+        private:
+            struct Slot
+            {
+                std::atomic<int64_t> timestamp{ 0 };
+                std::atomic<uintptr_t> function{ 0 };
+                std::atomic<uint32_t> labelAndType{ 0 };
+            };
+
+            std::unique_ptr<Slot[]> mSlots;
+            uint64_t mMask;
+            std::atomic<uint64_t> mHead{ 0 };
+            std::atomic<uint64_t> mWriting{ 0 };
+        };
+
+    } // namespace Internal
+} // namespace JobSystem
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <atomic>
+#include <type_traits>
+
+namespace JobSystem
+{
+  /**
+   * Bounded Chase-Lev work-stealing deque
+   * `Push()` and `Pop()` are owner-only and work on the private (LIFO) bottom end without any CAS,
+   * `Steal()` can be called from any thread and takes from the public (FIFO) top end.
+   * See: Le, Pop, Cohen, Zappa Nardelli - Correct and Efficient Work-Stealing for Weak Memory Models (PPoPP'13)
+   */
+  template<typename T> class WorkStealingQueue
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingQueue only holds trivially copyable elements");
+
+  public:
+    WorkStealingQueue(size_t bufferSize);
+    ~WorkStealingQueue();
+    WorkStealingQueue(WorkStealingQueue const &) = delete;
+
+    void operator=(WorkStealingQueue const &) = delete;
+
+    // owner thread only
+    bool Push(T const & data);
+    bool Pop(T & data);
+    // pushes as many as fit and publishes them with a single store, returns how many
+    size_t PushBulk(T const * data, size_t count);
+
+    // any thread
+    bool Steal(T & data);
+
+    bool IsEmpty() const noexcept;
+
+    size_t Size() const noexcept;
+
+    size_t Capacity() const noexcept;
+
+  private:
+    // Stealers may read a cell speculatively while the owner writes it, so cells are relaxed atomics
+    typedef std::atomic<T> Cell;
+
+    // Same layout rules as `BoundedMpmcQueue`: keep the indices on separate cache lines
+    static size_t const cachelineSize = 64;
+    typedef char CachelinePadType[cachelineSize];
+
+    CachelinePadType pad0_{};
+    Cell * const mBuffer;
+    int64_t const mBufferMask;
+    volatile CachelinePadType pad1_{};
+    std::atomic<int64_t> mBottom{};
+    volatile CachelinePadType pad2_{};
+    std::atomic<int64_t> mTop{};
+    volatile CachelinePadType pad3_{};
+  };
+
+  template<typename T> WorkStealingQueue<T>::WorkStealingQueue(size_t bufferSize) : mBuffer(new Cell[bufferSize]), mBufferMask(static_cast<int64_t>(bufferSize) - 1)
+  {
+    assert((bufferSize >= 2) && ((bufferSize & (bufferSize - 1)) == 0));
+    for (size_t i = 0; i != bufferSize; i += 1) { mBuffer[i].store(T{}, std::memory_order_relaxed); }
+    mBottom.store(0, std::memory_order_relaxed);
+    mTop.store(0, std::memory_order_relaxed);
+  }
+
+  template<typename T> WorkStealingQueue<T>::~WorkStealingQueue() { delete[] mBuffer; }
+
+  template<typename T> bool WorkStealingQueue<T>::Push(const T & data)
+  {
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    const int64_t top = mTop.load(std::memory_order_acquire);
+    // full; `top` only grows so a stale value can only make us more conservative
+    if (bottom - top > mBufferMask) return false;
+
+    mBuffer[bottom & mBufferMask].store(data, std::memory_order_relaxed);
+    // a release store rather than a fence: same code on x86, and thread sanitizer sees the hand-over
+    mBottom.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  template<typename T> size_t WorkStealingQueue<T>::PushBulk(const T * data, size_t count)
+  {
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    const int64_t top = mTop.load(std::memory_order_acquire);
+    const auto numFree = static_cast<size_t>(mBufferMask + 1 - (bottom - top));
+    if (count > numFree) count = numFree;
+    if (count == 0) return 0;
+
+    for (size_t i = 0; i < count; ++i) { mBuffer[(bottom + static_cast<int64_t>(i)) & mBufferMask].store(data[i], std::memory_order_relaxed); }
+    mBottom.store(bottom + static_cast<int64_t>(count), std::memory_order_release);
+    return count;
+  }
+
+  template<typename T> bool WorkStealingQueue<T>::Pop(T & data)
+  {
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = mTop.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+      // empty, restore
+      mBottom.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    data = mBuffer[bottom & mBufferMask].load(std::memory_order_relaxed);
+    if (top != bottom) {
+      // more than one element left, no stealer can reach this one
+      return true;
+    }
+
+    // last element, race against stealers for it
+    const bool hasWon = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    mBottom.store(bottom + 1, std::memory_order_relaxed);
+    return hasWon;
+  }
+
+  template<typename T> bool WorkStealingQueue<T>::Steal(T & data)
+  {
+    int64_t top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = mBottom.load(std::memory_order_acquire);
+
+    if (top >= bottom) return false;
+
+    data = mBuffer[top & mBufferMask].load(std::memory_order_relaxed);
+    // lost the race against an other stealer or the owner popping the last element
+    return mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  }
+
+  template<typename T> bool WorkStealingQueue<T>::IsEmpty() const noexcept
+  {
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    const int64_t top = mTop.load(std::memory_order_relaxed);
+    return bottom <= top;
+  }
+
+  template<typename T> size_t WorkStealingQueue<T>::Size() const noexcept
+  {
+    const int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    const int64_t top = mTop.load(std::memory_order_relaxed);
+    return bottom >= top ? static_cast<size_t>(bottom - top) : 0;
+  }
+
+  template<typename T> size_t WorkStealingQueue<T>::Capacity() const noexcept { return static_cast<size_t>(mBufferMask + 1); }
+
+} // namespace JobSystem
@@ -0,0 +1,83 @@
+#if defined(__cpp_impl_coroutine)
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <ThreadPool/Coroutine.h>
+
+using JobSystem::SwitchTo;
+using JobSystem::SyncWait;
+using JobSystem::Task;
+using JobSystem::WhenAll;
+using JobSystem::WhenDone;
+using JobSystem::Internal::Job;
+using JobSystem::Internal::ThreadPool;
+
+namespace
+{
+  Task<int> Answer(ThreadPool & threadPool)
+  {
+    co_await SwitchTo(threadPool);
+    co_return 42;
+  }
+
+  Task<int> Compute(ThreadPool & threadPool, std::atomic<int> & counter)
+  {
+    Job * root = threadPool.CreateJob([&counter]() { counter++; });
+    for (int i = 0; i < 16; ++i) {
+      Job * child = threadPool.CreateJobAsChild(root, [&counter]() { counter++; });
+      threadPool.Schedule(child);
+    }
+    // resumes only after the root and all of its children
+    co_await WhenDone(threadPool, root);
+    const int afterRoot = counter.load();
+
+    std::vector<Job *> jobs;
+    for (int i = 0; i < 8; ++i) { jobs.push_back(threadPool.CreateJob([&counter]() { counter++; })); }
+    co_await WhenAll(threadPool, std::move(jobs));
+
+    const int answer = co_await Answer(threadPool);
+    co_return afterRoot + answer;
+  }
+} // namespace
+
+TEST(Coroutine, SyncWait)
+{
+  ThreadPool threadPool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
+
+  ASSERT_EQ(42, SyncWait(threadPool, Answer(threadPool)));
+}
+
+TEST(Coroutine, AwaitJobs)
+{
+  ThreadPool threadPool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
+
+  for (int run = 0; run < 100; ++run) {
+    std::atomic<int> counter{ 0 };
+    ASSERT_EQ(17 + 42, SyncWait(threadPool, Compute(threadPool, counter)));
+    ASSERT_EQ(17 + 8, counter.load());
+  }
+}
+
+TEST(Coroutine, ManyTasks)
+{
+  ThreadPool threadPool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
+
+  std::atomic<int> counter{ 0 };
+  auto spawnAll = [&]() -> Task<void> {
+    std::vector<Job *> jobs;
+    for (int i = 0; i < 256; ++i) {
+      // nested SyncWait() inside a job helps executing like `ThreadPool::Wait()`
+      jobs.push_back(threadPool.CreateJob([&]() {
+        if (SyncWait(threadPool, Answer(threadPool)) == 42) { counter++; }
+      }));
+    }
+    co_await WhenAll(threadPool, std::move(jobs));
+  };
+  SyncWait(threadPool, spawnAll());
+  ASSERT_EQ(256, counter.load());
+}
+
+#endif
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+
+#include <ThreadPool/FrameArena.h>
+
+TEST(FrameArena, AllocateAligned)
+{
+  // given
+  JobSystem::FrameArena arena(1024);
+
+  // when
+  for (const size_t alignment : { 1u, 8u, 16u, 64u, 256u }) {
+    void * memory = arena.Allocate(3, alignment);
+
+    // then
+    ASSERT_TRUE(memory);
+    ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(memory) % alignment);
+    std::memset(memory, 0xcd, 3);
+  }
+}
+
+TEST(FrameArena, Grow)
+{
+  // given
+  JobSystem::FrameArena arena(1024);
+
+  // when
+  char * first = static_cast<char *>(arena.Allocate(600, 1));
+  char * second = static_cast<char *>(arena.Allocate(600, 1));
+  char * big = static_cast<char *>(arena.Allocate(10000, 1));
+
+  // then
+  // each went into a block of its own, the big one too
+  ASSERT_TRUE(first && second && big);
+  ASSERT_TRUE(second >= first + 600 || second + 600 <= first);
+  std::memset(first, 1, 600);
+  std::memset(second, 2, 600);
+  std::memset(big, 3, 10000);
+  ASSERT_EQ(2 * 1024u + 10000u, arena.Capacity());
+}
+
+TEST(FrameArena, ResetReusesBlocks)
+{
+  // given
+  JobSystem::FrameArena arena(1024);
+  void * first = arena.Allocate(600, 1);
+  arena.Allocate(600, 1);
+  arena.Allocate(600, 1);
+  const size_t capacity = arena.Capacity();
+
+  // when
+  arena.Reset();
+
+  // then
+  ASSERT_EQ(first, arena.Allocate(600, 1));
+  arena.Allocate(600, 1);
+  arena.Allocate(600, 1);
+  ASSERT_EQ(capacity, arena.Capacity());
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include <ThreadPool/JobAllocator.h>
+
+TEST(JobAllocator, ReuseLocal)
+{
+  JobSystem::JobAllocator allocator(16, 64, 16);
+
+  void * memory = allocator.Allocate();
+  ASSERT_TRUE(memory);
+  allocator.Deallocate(memory);
+
+  // LIFO freelist, the hot block comes back first
+  ASSERT_EQ(memory, allocator.Allocate());
+}
+
+TEST(JobAllocator, Overflow)
+{
+  JobSystem::JobAllocator allocator(16, 64, 16);
+  for (size_t i = 0; i < 16; ++i) { ASSERT_TRUE(allocator.Allocate()); }
+
+  ASSERT_FALSE(allocator.Allocate());
+}
+
+TEST(JobAllocator, RemoteDeallocate)
+{
+  constexpr size_t numElements = 256;
+  JobSystem::JobAllocator allocator(numElements, 64, 16);
+
+  std::vector<void *> blocks;
+  for (size_t i = 0; i < numElements; ++i) { blocks.push_back(allocator.Allocate()); }
+  ASSERT_FALSE(allocator.Allocate());
+
+  // when other threads return every block
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = t; i < numElements; i += 4) { allocator.DeallocateRemote(blocks[i]); }
+    });
+  }
+  for (auto & thread : threads) { thread.join(); }
+
+  // then the owner can hand out all of them again
+  for (size_t i = 0; i < numElements; ++i) { ASSERT_TRUE(allocator.Allocate()) << i; }
+  ASSERT_FALSE(allocator.Allocate());
+}
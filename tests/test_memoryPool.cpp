@@ -2,6 +2,9 @@
 #include <gtest/gtest.h>
 #include <thread>
 #include <atomic>
+#include <cstring>
+#include <set>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 #include <ThreadPool/MemoryPoolAllocator.h>
@@ -57,3 +60,49 @@ TEST_F(MemoryPool, raceConditions)
 
   for (auto & thread : threads) { thread.join(); }
 }
+
+TEST_F(MemoryPool, grow)
+{
+  // given
+  JobSystem::MemoryPoolAllocator allocator(256, 16, 16, 4);
+  ASSERT_EQ(256u * 16u, allocator.Capacity());
+
+  // when
+  std::set<void *> blocks;
+  for (size_t i = 0; i < 4 * 256; ++i) {
+    void * memory = allocator.Allocate();
+    ASSERT_TRUE(memory);
+    std::memset(memory, 0xcd, 16);
+    blocks.insert(memory);
+  }
+
+  // then
+  ASSERT_EQ(4u * 256u, blocks.size());
+  ASSERT_EQ(4u * 256u * 16u, allocator.Capacity());
+  ASSERT_FALSE(allocator.Allocate());
+
+  // returned blocks are handed out again, from any chunk
+  for (void * memory : blocks) { allocator.Deallocate(memory); }
+  for (size_t i = 0; i < 4 * 256; ++i) { ASSERT_EQ(1u, blocks.count(allocator.Allocate())); }
+  ASSERT_FALSE(allocator.Allocate());
+}
+
+TEST_F(MemoryPool, pageBacking)
+{
+  for (const auto backing : { JobSystem::PoolBacking::Pages, JobSystem::PoolBacking::TransparentHugePages, JobSystem::PoolBacking::HugePages }) {
+    // given
+    JobSystem::MemoryPoolAllocator allocator(4096, 128, 64, 2, backing);
+
+    // when
+    std::vector<void *> blocks;
+    for (void * memory = allocator.Allocate(); memory; memory = allocator.Allocate()) {
+      ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(memory) % 64);
+      std::memset(memory, 0xcd, 128);
+      blocks.push_back(memory);
+    }
+
+    // then
+    ASSERT_EQ(2u * 4096u, blocks.size()) << static_cast<int>(backing);
+    for (void * memory : blocks) { allocator.Deallocate(memory); }
+  }
+}
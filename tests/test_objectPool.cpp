@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ThreadPool/ObjectPool.h>
+
+namespace
+{
+  struct Tracked
+  {
+    explicit Tracked(std::atomic<int> & liveObjects, int value) : liveObjects(liveObjects), value(value) { ++liveObjects; }
+    ~Tracked() { --liveObjects; }
+
+    std::atomic<int> & liveObjects;
+    int value;
+    std::string name = "a name long enough to live on the heap, so leaks show up in sanitizers";
+  };
+
+  struct alignas(64) Aligned
+  {
+    char data[8];
+  };
+
+  struct Throwing
+  {
+    Throwing() { throw 42; }
+  };
+} // namespace
+
+TEST(ObjectPool, CreateDestroy)
+{
+  // given
+  std::atomic<int> liveObjects{ 0 };
+  JobSystem::ObjectPool<Tracked> pool(256);
+
+  // when
+  std::vector<Tracked *> objects;
+  for (int i = 0; i < 200; ++i) {
+    Tracked * object = pool.Create(liveObjects, i);
+    ASSERT_TRUE(object);
+    objects.push_back(object);
+  }
+
+  // then
+  ASSERT_EQ(200, liveObjects.load());
+  for (int i = 0; i < 200; ++i) { ASSERT_EQ(i, objects[i]->value); }
+  for (Tracked * object : objects) { pool.Destroy(object); }
+  ASSERT_EQ(0, liveObjects.load());
+}
+
+TEST(ObjectPool, Alignment)
+{
+  JobSystem::ObjectPool<Aligned> pool(64);
+  std::vector<Aligned *> objects;
+  for (int i = 0; i < 32; ++i) {
+    objects.push_back(pool.Create());
+    ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(objects.back()) % alignof(Aligned));
+  }
+  for (Aligned * object : objects) { pool.Destroy(object); }
+}
+
+TEST(ObjectPool, Exhausted)
+{
+  // given
+  JobSystem::ObjectPool<int> pool(64);
+
+  // when
+  std::vector<int *> objects;
+  for (int * object = pool.Create(1); object; object = pool.Create(1)) { objects.push_back(object); }
+
+  // then
+  // a single thread has nothing stuck in other magazines, so it gets every block
+  ASSERT_EQ(64u, objects.size());
+  for (int * object : objects) { pool.Destroy(object); }
+  ASSERT_TRUE(pool.Create(2));
+}
+
+TEST(ObjectPool, ConstructorThrows)
+{
+  JobSystem::ObjectPool<Throwing> pool(1);
+  ASSERT_THROW(pool.Create(), int);
+  ASSERT_THROW(pool.Create(), int); // the block went back to the pool
+}
+
+TEST(ObjectPool, ManyThreads)
+{
+  // given
+  unsigned numThreads = std::thread::hardware_concurrency();
+  numThreads = numThreads ? numThreads : 2;
+  std::atomic<int> liveObjects{ 0 };
+  JobSystem::ObjectPool<Tracked> pool(numThreads * (JobSystem::ObjectPool<Tracked>::magazineSize + 64));
+
+  // when
+  // every thread keeps a few alive, and objects created on one thread get destroyed on an other
+  std::vector<std::vector<Tracked *>> handOver(numThreads);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<Tracked *> objects;
+      for (int i = 0; i < 100000; ++i) {
+        Tracked * object = pool.Create(liveObjects, i);
+        ASSERT_TRUE(object);
+        objects.push_back(object);
+        if (objects.size() == 64) {
+          for (Tracked * alive : objects) { ASSERT_EQ(alive->name.size(), objects.front()->name.size()); }
+          for (size_t j = 0; j < 32; ++j) { pool.Destroy(objects[j]); }
+          objects.erase(objects.begin(), objects.begin() + 32);
+        }
+      }
+      handOver[t] = std::move(objects);
+    });
+  }
+  for (auto & thread : threads) { thread.join(); }
+  for (auto & objects : handOver) {
+    for (Tracked * object : objects) { pool.Destroy(object); }
+  }
+
+  // then
+  ASSERT_EQ(0, liveObjects.load());
+}
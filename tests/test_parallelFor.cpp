@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+
+#include <ThreadPool/ParallelFor.h>
+
+using JobSystem::Internal::AutoSplitter;
+using JobSystem::Internal::CountSplitter;
+using JobSystem::Internal::DataSizeSplitter;
+using JobSystem::Internal::Job;
+using JobSystem::Internal::ParallelFor;
+using JobSystem::Internal::ThreadPool;
+
+namespace
+{
+  template<typename SplitterType> void RunAndCheck(ThreadPool & threadPool, size_t begin, size_t count, const SplitterType & splitter, size_t maxLeafCount)
+  {
+    std::vector<std::atomic<int>> visits(begin + count);
+    std::atomic<size_t> leafCount{ 0 };
+
+    Job * job = ParallelFor(
+      threadPool, begin, count,
+      [&](size_t leafBegin, size_t leafCount_) {
+        EXPECT_LE(leafCount_, maxLeafCount);
+        for (size_t i = leafBegin; i < leafBegin + leafCount_; ++i) { visits[i]++; }
+        leafCount++;
+      },
+      splitter);
+    threadPool.Schedule(job);
+    threadPool.Wait(job);
+
+    for (size_t i = 0; i < begin; ++i) { ASSERT_EQ(0, visits[i].load()) << i; }
+    for (size_t i = begin; i < begin + count; ++i) { ASSERT_EQ(1, visits[i].load()) << i; }
+    ASSERT_GE(leafCount.load(), count / maxLeafCount);
+  }
+} // namespace
+
+TEST(ParallelFor, CountSplitter)
+{
+  ThreadPool threadPool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
+  RunAndCheck(threadPool, 3, 10000, CountSplitter(64), 64);
+}
+
+TEST(ParallelFor, DataSizeSplitter)
+{
+  ThreadPool threadPool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
+  RunAndCheck(threadPool, 0, 100000, DataSizeSplitter(4096, sizeof(float)), 1024);
+}
+
+TEST(ParallelFor, AutoSplitter)
+{
+  ThreadPool threadPool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
+  const size_t count = 100000;
+  const AutoSplitter splitter(threadPool, count);
+  RunAndCheck(threadPool, 0, count, splitter, count);
+}
+
+TEST(ParallelFor, NoSplit)
+{
+  ThreadPool threadPool(2);
+  RunAndCheck(threadPool, 0, 10, CountSplitter(64), 10);
+}
+
+// splitters that would split a single element again still end with one element per leaf
+TEST(ParallelFor, SplitDownToSingleElements)
+{
+  ThreadPool threadPool(2);
+  RunAndCheck(threadPool, 0, 1000, CountSplitter(0), 1);
+  RunAndCheck(threadPool, 0, 10, AutoSplitter(threadPool, 10, 0), 1);
+  RunAndCheck(threadPool, 0, 1000, DataSizeSplitter(2, sizeof(float)), 1);
+}
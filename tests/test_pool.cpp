@@ -1,13 +1,20 @@
 #include <gtest/gtest.h>
+#include <array>
 #include <future>
+#include <chrono>
 #include <unordered_set>
 
 #include <spdlog/spdlog.h>
 
 #include <ThreadPool/ThreadPool.h>
+#include <ThreadPool/ObjectPool.h>
 
 using JobSystem::Internal::ThreadPool;
 using JobSystem::Internal::Job;
+using JobSystem::Internal::IdlePolicy;
+using JobSystem::Internal::OverflowPolicy;
+using JobSystem::Internal::ThreadPoolConfig;
+using JobSystem::Internal::Priority;
 
 struct TestJobData
 {
@@ -31,29 +38,610 @@ TEST(PoolTest, PoolTest)
   const size_t numThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2;
   ThreadPool threadPool(numThreads);
 
-  JobSystem::MemoryPoolAllocator allocator(maxJobCount, sizeof(TestJobData));
+  JobSystem::ObjectPool<TestJobData> dataPool(maxJobCount);
 
   // When
   Job * jobs[maxJobCount] = {};
+  TestJobData * jobData[maxJobCount] = {};
   size_t counter = 0;
-  for (Job *& job : jobs) {
-    auto * data = reinterpret_cast<TestJobData *>(allocator.Allocate());
+  for (size_t i = 0; i < maxJobCount; ++i) {
+    TestJobData * data = dataPool.Create(TestJobData{ counter++, 0 });
     ASSERT_TRUE(data);
+    jobData[i] = data;
 
-    data->counter = counter++;
-    data->result = 0;
+    jobs[i] = threadPool.CreateJob(&TestJobFunction, data);
+    threadPool.Schedule(jobs[i]);
 
-    job = threadPool.CreateJob(&TestJobFunction, data);
+    ASSERT_TRUE(jobs[i]);
+  }
+
+  // Then
+  for (size_t i = 0; i < maxJobCount; ++i) {
+    threadPool.Wait(jobs[i]);
+    ASSERT_EQ(jobData[i]->counter + 1, jobData[i]->result);
+    dataPool.Destroy(jobData[i]);
+  }
+}
+
+struct SpawnJobData
+{
+  ThreadPool * threadPool;
+  std::atomic<size_t> counter;
+};
+
+void CountingJobFunction(Job * job, void * rawData)
+{
+  auto * data = reinterpret_cast<SpawnJobData *>(rawData);
+  data->counter++;
+}
+
+void SpawningJobFunction(Job * job, void * rawData)
+{
+  // children are pushed into the queue of whichever worker runs this job
+  auto * data = reinterpret_cast<SpawnJobData *>(rawData);
+  for (size_t i = 0; i < 64; ++i) {
+    Job * child = data->threadPool->CreateJobAsChild(job, &CountingJobFunction, data);
+    data->threadPool->Schedule(child);
+  }
+}
+
+TEST(PoolTest, ScheduleFromWorker)
+{
+  // Given
+  const size_t numThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2;
+  ThreadPool threadPool(numThreads);
+
+  SpawnJobData data;
+  data.threadPool = &threadPool;
+  data.counter = 0;
+
+  // When
+  Job * root = threadPool.CreateJob(&SpawningJobFunction, &data);
+  threadPool.Schedule(root);
+  threadPool.Wait(root);
+
+  // Then
+  ASSERT_EQ(64u, data.counter.load());
+}
+
+TEST(PoolTest, WakeUpAfterIdle)
+{
+  for (const IdlePolicy idlePolicy : { IdlePolicy::Spin, IdlePolicy::Yield, IdlePolicy::Adaptive }) {
+    // Given
+    ThreadPoolConfig config;
+    config.idlePolicy = idlePolicy;
+    ThreadPool threadPool(2, config);
+
+    // let every worker run out of work, and park if the policy says so
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    SpawnJobData data;
+    data.threadPool = &threadPool;
+    data.counter = 0;
+
+    // When
+    Job * root = threadPool.CreateJob(&SpawningJobFunction, &data);
+    threadPool.Schedule(root);
+    threadPool.Wait(root);
+
+    // Then
+    ASSERT_EQ(64u, data.counter.load());
+  }
+}
+
+TEST(PoolTest, TypedJobs)
+{
+  constexpr size_t jobCount = 256;
+
+  // Given
+  const size_t numThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2;
+  ThreadPool threadPool(numThreads);
+
+  // When
+  size_t results[jobCount] = {};
+  Job * root = threadPool.CreateJob([]() {});
+  for (size_t i = 0; i < jobCount; ++i) {
+    Job * job = threadPool.CreateJobAsChild(root, [i, &results]() { results[i] = i + 1; });
     threadPool.Schedule(job);
+  }
+  threadPool.Schedule(root);
+  threadPool.Wait(root);
+
+  // Then
+  for (size_t i = 0; i < jobCount; ++i) { ASSERT_EQ(i + 1, results[i]); }
+}
+
+TEST(PoolTest, TypedJobsLargeCapture)
+{
+  // Given
+  ThreadPool threadPool(2);
+
+  std::array<size_t, 64> values = {};
+  for (size_t i = 0; i < values.size(); ++i) { values[i] = i; }
+  auto counter = std::make_shared<size_t>(0);
+
+  // When a capture does not fit into the job
+  size_t sum = 0;
+  Job * job = threadPool.CreateJob([values, counter, &sum](Job *) {
+    for (size_t value : values) { sum += value; }
+  });
+  ASSERT_EQ(2, counter.use_count());
+  threadPool.Schedule(job);
+  threadPool.Wait(job);
+
+  // Then it still runs, and gets destroyed once the job is released
+  ASSERT_EQ(63u * 64u / 2u, sum);
+  while (counter.use_count() != 1) { std::this_thread::yield(); }
+}
+
+TEST(PoolTest, Continuations)
+{
+  // Given
+  const size_t numThreads = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2;
+  ThreadPool threadPool(numThreads);
+
+  std::atomic<int> step{ 0 };
+  std::atomic<int> fanOut{ 0 };
+  int order[3] = {};
+
+  // When a -> b -> c, and a also has children and a few more continuations
+  Job * a = threadPool.CreateJob([&](Job * job) {
+    for (int i = 0; i < 16; ++i) { threadPool.Schedule(threadPool.CreateJobAsChild(job, [&]() { fanOut++; })); }
+    order[0] = step++;
+  });
+  Job * b = threadPool.CreateJob([&]() {
+    // every child of the antecedent has finished by now
+    EXPECT_EQ(16, fanOut.load());
+    order[1] = step++;
+  });
+  Job * c = threadPool.CreateJob([&]() { order[2] = step++; });
+  threadPool.AddContinuation(a, b);
+  threadPool.AddContinuation(b, c);
+
+  std::atomic<int> siblings{ 0 };
+  for (int i = 0; i < 4; ++i) { threadPool.AddContinuation(a, threadPool.CreateJobAsChild(c, [&]() { siblings++; })); }
+
+  threadPool.Schedule(a);
+  threadPool.Wait(c);
+
+  // Then
+  ASSERT_EQ(0, order[0]);
+  ASSERT_EQ(1, order[1]);
+  ASSERT_EQ(2, order[2]);
+  ASSERT_EQ(4, siblings.load());
+}
+
+namespace
+{
+  // keeps the only worker of the pool busy, so everything the main thread schedules runs on the main thread in Wait()
+  struct WorkerBlocker
+  {
+    explicit WorkerBlocker(ThreadPool & threadPool)
+    {
+      threadPool.Schedule(threadPool.CreateJob([this]() {
+        isStarted = true;
+        while (!isReleased) { std::this_thread::yield(); }
+      }));
+      while (!isStarted) { std::this_thread::yield(); }
+    }
+    ~WorkerBlocker() { isReleased = true; }
+
+    std::atomic<bool> isStarted{ false };
+    std::atomic<bool> isReleased{ false };
+  };
+} // namespace
+
+TEST(PoolTest, Priorities)
+{
+  // Given
+  ThreadPool threadPool(1);
+  WorkerBlocker blocker(threadPool);
+
+  std::vector<Priority> order;
+  Job * root = threadPool.CreateJob([]() {});
+
+  // When
+  for (const Priority priority : { Priority::Low, Priority::Normal, Priority::High }) {
+    for (int i = 0; i < 4; ++i) { threadPool.Schedule(threadPool.CreateJobAsChild(root, [&order, priority]() { order.push_back(priority); }), priority); }
+  }
+  threadPool.Schedule(root, Priority::Low);
+  threadPool.Wait(root);
+
+  // Then
+  ASSERT_EQ(12u, order.size());
+  for (size_t i = 0; i < order.size(); ++i) { ASSERT_EQ(static_cast<Priority>(i / 4), order[i]) << i; }
+}
+
+TEST(PoolTest, PriorityAging)
+{
+  // Given
+  ThreadPoolConfig config;
+  config.priorityAgingLimit = 4;
+  ThreadPool threadPool(1, config);
+  WorkerBlocker blocker(threadPool);
+
+  std::vector<Priority> order;
+  Job * root = threadPool.CreateJob([]() {});
+
+  // When
+  threadPool.Schedule(threadPool.CreateJobAsChild(root, [&order]() { order.push_back(Priority::Low); }), Priority::Low);
+  for (int i = 0; i < 16; ++i) { threadPool.Schedule(threadPool.CreateJobAsChild(root, [&order]() { order.push_back(Priority::High); }), Priority::High); }
+  threadPool.Schedule(root, Priority::High);
+  threadPool.Wait(root);
+
+  // Then the low priority job did not have to wait for every high priority one
+  ASSERT_EQ(17u, order.size());
+  ASSERT_NE(Priority::Low, order.back());
+}
+
+namespace
+{
+  // fork-join fib, every level waits for its two halves
+  struct FibData
+  {
+    ThreadPool * threadPool;
+    int n;
+    int64_t result;
+  };
+
+  void FibJobFunction(Job *, void * rawData)
+  {
+    auto * data = reinterpret_cast<FibData *>(rawData);
+    if (data->n < 2) {
+      data->result = data->n;
+      return;
+    }
+
+    ThreadPool & threadPool = *data->threadPool;
+    FibData halves[2] = { { &threadPool, data->n - 1, 0 }, { &threadPool, data->n - 2, 0 } };
+    Job * root = threadPool.CreateJob([]() {});
+    for (FibData & half : halves) { threadPool.Schedule(threadPool.CreateJobAsChild(root, &FibJobFunction, &half)); }
+    threadPool.Schedule(root);
+    threadPool.Wait(root);
+    data->result = halves[0].result + halves[1].result;
+  }
+} // namespace
+
+TEST(PoolTest, FiberWait)
+{
+  if (!JobSystem::Fiber::isSupported) GTEST_SKIP() << "no fibers on this platform";
+
+  // Given
+  ThreadPoolConfig config;
+  config.useFibers = true;
+  ThreadPool threadPool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2, config);
+
+  // When
+  FibData data = { &threadPool, 18, 0 };
+  Job * job = threadPool.CreateJob(&FibJobFunction, &data);
+  threadPool.Schedule(job);
+  threadPool.Wait(job);
+
+  // Then
+  ASSERT_EQ(2584, data.result);
+}
+
+TEST(PoolTest, FiberWaitOutOfFibers)
+{
+  if (!JobSystem::Fiber::isSupported) GTEST_SKIP() << "no fibers on this platform";
+
+  // Given so few fibers that most waits fall back to the stack they are on
+  ThreadPoolConfig config;
+  config.useFibers = true;
+  config.fibersPerWorker = 2;
+  ThreadPool threadPool(2, config);
+
+  // When
+  FibData data = { &threadPool, 16, 0 };
+  Job * job = threadPool.CreateJob(&FibJobFunction, &data);
+  threadPool.Schedule(job);
+  threadPool.Wait(job);
+
+  // Then
+  ASSERT_EQ(987, data.result);
+}
+
+TEST(PoolTest, Stats)
+{
+  if (!JobSystem::Internal::ThreadPoolStats::isEnabled) GTEST_SKIP() << "stats are compiled out";
+
+  // Given
+  ThreadPool threadPool(2);
+
+  // When
+  Job * root = threadPool.CreateJob([]() {});
+  for (int i = 0; i < 100; ++i) { threadPool.Schedule(threadPool.CreateJobAsChild(root, []() {})); }
+  threadPool.Schedule(root);
+  threadPool.Wait(root);
+  const auto stats = threadPool.GetStats();
+
+  // Then
+  ASSERT_EQ(3u, stats.workers.size());
+  ASSERT_EQ(101u, stats.workers.back().jobsScheduled);
+  ASSERT_EQ(101u, stats.total.jobsScheduled);
+  ASSERT_EQ(101u, stats.total.jobsExecuted);
+  ASSERT_EQ(0u, stats.total.failedPushes);
+  ASSERT_LE(stats.total.stealSuccesses, stats.total.stealAttempts);
+  ASSERT_GE(stats.total.queueHighWater, 1u);
+}
+
+TEST(PoolTest, QueueOverflow)
+{
+  for (const OverflowPolicy policy : { OverflowPolicy::Spill, OverflowPolicy::RunInline, OverflowPolicy::Backpressure }) {
+    // Given
+    ThreadPoolConfig config;
+    config.overflowPolicy = policy;
+    ThreadPool threadPool(1, config);
+
+    // persistent jobs don't take slots from the allocators, so the queue is the only limit
+    const size_t numJobs = 3 * ThreadPool::maxJobCount;
+    std::vector<Job> jobs(numJobs + 1);
+    std::atomic<size_t> counter{ 0 };
+    Job * root = &jobs[numJobs];
+    threadPool.InitializePersistentJob(root, nullptr, nullptr);
+    root->unfinishedJobs.store(static_cast<char32_t>(numJobs), std::memory_order_relaxed);
+
+    // When
+    WorkerBlocker blocker(threadPool);
+    for (size_t i = 0; i < numJobs; ++i) {
+      threadPool.InitializePersistentJob(&jobs[i], [](Job *, void * data) { static_cast<std::atomic<size_t> *>(data)->fetch_add(1); }, &counter, root);
+      threadPool.Schedule(&jobs[i]);
+    }
+    threadPool.Wait(root);
+
+    // Then
+    ASSERT_EQ(numJobs, counter.load()) << static_cast<int>(policy);
+    if (JobSystem::Internal::ThreadPoolStats::isEnabled) { ASSERT_LT(0u, threadPool.GetStats().total.failedPushes); }
+  }
+}
+
+TEST(PoolTest, MoreJobsThanSlots)
+{
+  // Given
+  ThreadPoolConfig config;
+  config.maxSharedJobChunks = 1;
+  ThreadPool threadPool(1, config);
+  std::atomic<size_t> counter{ 0 };
+
+  // When
+  // more than the main thread's allocator and the shared one hold, creating them has to wait for some to finish
+  const size_t numJobs = 5 * ThreadPool::maxJobCount;
+  Job * root = threadPool.CreateJob([]() {});
+  for (size_t i = 0; i < numJobs; ++i) { threadPool.Schedule(threadPool.CreateJobAsChild(root, [&counter]() { counter++; })); }
+  threadPool.Schedule(root);
+  threadPool.Wait(root);
+
+  // Then
+  ASSERT_EQ(numJobs, counter.load());
+}
+
+TEST(PoolTest, ScheduleBatch)
+{
+  // Given
+  ThreadPool threadPool(2);
+  std::atomic<size_t> counter{ 0 };
+  std::atomic<size_t> highPriorityCounter{ 0 };
+
+  // When
+  // more than fits into a queue, in runs of different priorities
+  const size_t numJobs = ThreadPool::maxJobCount + 100;
+  Job * root = threadPool.CreateJob([]() {});
+  std::vector<Job *> jobs;
+  for (size_t i = 0; i < numJobs; ++i) {
+    if (i % 1000 < 10) {
+      jobs.push_back(threadPool.CreateJobAsChild(root, [&highPriorityCounter]() { highPriorityCounter++; }));
+      jobs.back()->priority = Priority::High;
+    } else {
+      jobs.push_back(threadPool.CreateJobAsChild(root, [&counter]() { counter++; }));
+    }
+  }
+  threadPool.ScheduleBatch(jobs.data(), jobs.size());
+  threadPool.Schedule(root);
+  threadPool.Wait(root);
 
-    ASSERT_TRUE(job);
+  // Then
+  ASSERT_EQ(50u, highPriorityCounter.load());
+  ASSERT_EQ(numJobs - 50u, counter.load());
+}
+
+TEST(PoolTest, ExternalThreads)
+{
+  // Given
+  ThreadPoolConfig config;
+  config.externalThreadSlots = 1;
+  ThreadPool threadPool(2, config);
+  std::atomic<size_t> counter{ 0 };
+  std::atomic<size_t> numRegistered{ 0 };
+
+  // When
+  // threads the pool knows nothing about submit through the injection queue, one of them gets a worker of its own
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      const bool isRegistered = threadPool.RegisterExternalThread();
+      if (isRegistered) {
+        numRegistered++;
+        EXPECT_FALSE(threadPool.RegisterExternalThread());
+      }
+
+      for (int round = 0; round < 10; ++round) {
+        Job * root = threadPool.CreateJob([]() {});
+        std::vector<Job *> jobs;
+        for (int j = 0; j < 100; ++j) { jobs.push_back(threadPool.CreateJobAsChild(root, [&counter]() { counter++; })); }
+        threadPool.ScheduleBatch(jobs.data(), jobs.size());
+        threadPool.Schedule(threadPool.CreateJobAsChild(root, [&counter]() { counter++; }), Priority::High);
+        threadPool.Schedule(root);
+        threadPool.Wait(root);
+      }
+
+      if (isRegistered) threadPool.UnregisterExternalThread();
+    });
+  }
+  for (auto & thread : threads) { thread.join(); }
+
+  // Then
+  ASSERT_EQ(4u * 10u * 101u, counter.load());
+  ASSERT_LE(1u, numRegistered.load());
+  ASSERT_FALSE(threadPool.RegisterExternalThread()); // the main thread has a worker already
+}
+
+TEST(PoolTest, ElasticWorkers)
+{
+  for (const IdlePolicy idlePolicy : { IdlePolicy::Spin, IdlePolicy::Yield, IdlePolicy::Adaptive }) {
+    // Given
+    ThreadPoolConfig config;
+    config.idlePolicy = idlePolicy;
+    config.elasticWorkers = true;
+    config.minWorkers = 1;
+    config.retireAfterMicroseconds = 1000;
+    ThreadPool threadPool(4, config);
+
+    // idle workers retire down to the minimum
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (threadPool.NumActiveWorkers() > 1 && std::chrono::steady_clock::now() < deadline) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+    ASSERT_EQ(1u, threadPool.NumActiveWorkers()) << static_cast<int>(idlePolicy);
+
+    // When
+    // a backlog brings them back
+    std::atomic<size_t> counter{ 0 };
+    std::atomic<size_t> maxActiveWorkers{ 0 };
+    Job * root = threadPool.CreateJob([]() {});
+    for (int i = 0; i < 200; ++i) {
+      threadPool.Schedule(threadPool.CreateJobAsChild(root, [&]() {
+        size_t activeWorkers = threadPool.NumActiveWorkers();
+        size_t seen = maxActiveWorkers.load();
+        while (activeWorkers > seen && !maxActiveWorkers.compare_exchange_weak(seen, activeWorkers)) {}
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        counter++;
+      }));
+    }
+    threadPool.Schedule(root);
+    threadPool.Wait(root);
+
+    // Then
+    ASSERT_EQ(200u, counter.load());
+    ASSERT_LT(1u, maxActiveWorkers.load()) << static_cast<int>(idlePolicy);
+    if (JobSystem::Internal::ThreadPoolStats::isEnabled) { ASSERT_LE(3u, threadPool.GetStats().total.retirements); }
+  }
+}
+
+TEST(PoolTest, FrameArenas)
+{
+  // Given
+  ThreadPoolConfig config;
+  config.frameArenaBlockSize = 4096;
+  ThreadPool threadPool(2, config);
+  constexpr size_t numJobs = 256;
+  std::vector<uint32_t *> buffers(numJobs);
+
+  // When
+  auto runFrame = [&](uint32_t value) {
+    Job * root = threadPool.CreateJob([]() {});
+    for (size_t i = 0; i < numJobs; ++i) {
+      threadPool.Schedule(threadPool.CreateJobAsChild(root, [&threadPool, &buffers, i, value]() {
+        auto * buffer = static_cast<uint32_t *>(threadPool.AllocateFrame(64 * sizeof(uint32_t), 64));
+        ASSERT_TRUE(buffer);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(buffer) % 64);
+        for (size_t j = 0; j < 64; ++j) { buffer[j] = value; }
+        buffers[i] = buffer;
+      }));
+    }
+    threadPool.Schedule(root);
+    threadPool.Wait(root);
+  };
+  runFrame(1);
+  const std::vector<uint32_t *> firstFrame = buffers;
+  threadPool.ResetFrame();
+  runFrame(2);
+
+  // Then
+  // the previous frame is still intact while the next one allocates
+  ASSERT_EQ(1u, threadPool.Frame());
+  for (uint32_t * buffer : firstFrame) {
+    for (size_t j = 0; j < 64; ++j) { ASSERT_EQ(1u, buffer[j]); }
+  }
+  for (uint32_t * buffer : buffers) {
+    for (size_t j = 0; j < 64; ++j) { ASSERT_EQ(2u, buffer[j]); }
   }
+  // two frames later the arena starts over
+  threadPool.ResetFrame();
+  void * memory = threadPool.AllocateFrame(16);
+  threadPool.ResetFrame();
+  threadPool.ResetFrame();
+  ASSERT_EQ(memory, threadPool.AllocateFrame(16));
+}
+
+TEST(PoolTest, FrameLoop)
+{
+  // Given
+  ThreadPoolConfig config;
+  // any budget is at risk right away, so every deferrable job gets put off
+  config.frameShedPercent = 0;
+  ThreadPool threadPool(2, config);
+  constexpr size_t numDeferrable = 8;
+  constexpr auto sleep = std::chrono::milliseconds(3);
+  std::atomic<size_t> numDeferrableRuns{ 0 };
+  std::atomic<size_t> numNextFrameRuns{ 0 };
+
+  // When
+  threadPool.BeginFrame(std::chrono::nanoseconds(std::chrono::milliseconds(1)).count());
+  Job * first = threadPool.CreateFrameJob([sleep]() { std::this_thread::sleep_for(sleep); });
+  Job * second = threadPool.CreateFrameJob([sleep]() { std::this_thread::sleep_for(sleep); });
+  threadPool.AddContinuation(first, second);
+  for (size_t i = 0; i < numDeferrable; ++i) {
+    Job * job = threadPool.CreateFrameJob([&numDeferrableRuns]() { numDeferrableRuns++; });
+    ThreadPool::SetDeferrable(job);
+    threadPool.Schedule(job);
+  }
+  threadPool.ScheduleNextFrame(threadPool.CreateJob([&numNextFrameRuns]() { numNextFrameRuns++; }));
+  threadPool.Schedule(first);
+  const auto firstFrame = threadPool.EndFrame();
+  const size_t deferrableRunsInFirstFrame = numDeferrableRuns.load();
+  const size_t nextFrameRunsInFirstFrame = numNextFrameRuns.load();
+
+  threadPool.BeginFrame();
+  const auto secondFrame = threadPool.EndFrame();
 
   // Then
-  for (Job *& job : jobs) {
-    threadPool.Wait(job);
-    auto * data = reinterpret_cast<TestJobData *>(job->data);
-    ASSERT_TRUE(data->result = data->counter + 1);
-    allocator.Deallocate(job->data);
+  ASSERT_EQ(0u, deferrableRunsInFirstFrame);
+  ASSERT_EQ(0u, nextFrameRunsInFirstFrame);
+  ASSERT_EQ(numDeferrable, firstFrame.jobsDeferred);
+  // the two chained jobs make up the critical path, and the frame cannot be shorter
+  const int64_t chain = std::chrono::nanoseconds(2 * sleep).count();
+  ASSERT_GE(firstFrame.criticalPathNanoseconds, chain);
+  ASSERT_LE(firstFrame.criticalPathNanoseconds, firstFrame.durationNanoseconds);
+  ASSERT_EQ(firstFrame.durationNanoseconds - firstFrame.budgetNanoseconds, firstFrame.overrunNanoseconds);
+  ASSERT_EQ(3u, firstFrame.busyFractions.size());
+  double busyFractions = 0.0;
+  for (double busyFraction : firstFrame.busyFractions) {
+    ASSERT_GE(busyFraction, 0.0);
+    ASSERT_LE(busyFraction, 1.0);
+    busyFractions += busyFraction;
   }
+  ASSERT_GT(busyFractions, 0.5);
+
+  // put off once, then they run
+  ASSERT_EQ(firstFrame.frame + 1, secondFrame.frame);
+  ASSERT_EQ(numDeferrable, numDeferrableRuns.load());
+  ASSERT_EQ(1u, numNextFrameRuns.load());
+  ASSERT_EQ(0u, secondFrame.jobsDeferred);
+  ASSERT_EQ(0, secondFrame.overrunNanoseconds);
+}
+
+TEST(PoolTest, FrameLoopBackToBack)
+{
+  // Given
+  ThreadPool threadPool(2);
+  std::atomic<size_t> numRuns{ 0 };
+
+  // When every frame begins as soon as the previous one has ended, the frame root gets initialized again right away
+  constexpr size_t numFrames = 2000;
+  for (size_t frame = 0; frame < numFrames; ++frame) {
+    threadPool.BeginFrame();
+    for (int i = 0; i < 2; ++i) { threadPool.Schedule(threadPool.CreateFrameJob([&numRuns]() { numRuns++; })); }
+    threadPool.EndFrame();
+  }
+
+  // Then
+  ASSERT_EQ(2 * numFrames, numRuns.load());
 }
@@ -1,6 +1,14 @@
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <algorithm>
 #include "ThreadPool/BoundedMpmcQueue.h"
+#include "ThreadPool/BoundedQueue.h"
+#include "ThreadPool/WorkStealingQueue.h"
 
 TEST(StealingBoundedQueue, Overflow)
 {
@@ -21,3 +29,225 @@ TEST(StealingBoundedQueue, Undeflow)
   ASSERT_FALSE(queue.Pop(dummy));
 }
 
+TEST(StealingBoundedQueue, Bulk)
+{
+  JobSystem::BoundedMpmcQueue<int> queue(16);
+  const std::vector<int> input = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+  ASSERT_EQ(12u, queue.PushBulk(input.data(), input.size()));
+  // only what still fits
+  ASSERT_EQ(4u, queue.PushBulk(input.data(), input.size()));
+  ASSERT_EQ(0u, queue.PushBulk(input.data(), input.size()));
+
+  std::vector<int> output(32, -1);
+  ASSERT_EQ(10u, queue.PopBulk(output.data(), 10));
+  ASSERT_EQ(6u, queue.PopBulk(output.data() + 10, 32));
+  ASSERT_EQ(0u, queue.PopBulk(output.data(), 32));
+  for (size_t i = 0; i < 16; ++i) { ASSERT_EQ(input[i % 12], output[i]) << i; }
+}
+
+TEST(StealingBoundedQueue, ConcurrentBulk)
+{
+  constexpr int itemCount = 100000;
+  constexpr size_t bulkSize = 7;
+  JobSystem::BoundedMpmcQueue<int> queue(64);
+
+  const unsigned numThreads = std::max(2u, std::thread::hardware_concurrency());
+  std::vector<std::atomic<int>> seen(itemCount);
+  std::atomic<int> numTaken{ 0 };
+
+  // half of the threads push their share in bulks, the other half pops in bulks
+  std::vector<std::thread> threads;
+  const unsigned numProducers = numThreads / 2;
+  for (unsigned i = 0; i < numThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      if (i < numProducers) {
+        std::vector<int> items;
+        for (int item = static_cast<int>(i); item < itemCount; item += static_cast<int>(numProducers)) items.push_back(item);
+        for (size_t first = 0; first < items.size();) {
+          first += queue.PushBulk(items.data() + first, std::min(bulkSize, items.size() - first));
+          std::this_thread::yield();
+        }
+      } else {
+        int items[bulkSize];
+        while (numTaken.load() < itemCount) {
+          const size_t count = queue.PopBulk(items, bulkSize);
+          for (size_t j = 0; j < count; ++j) seen[static_cast<size_t>(items[j])]++;
+          numTaken += static_cast<int>(count);
+          if (!count) std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto & thread : threads) { thread.join(); }
+
+  for (int i = 0; i < itemCount; ++i) { ASSERT_EQ(1, seen[static_cast<size_t>(i)].load()) << i; }
+}
+
+
+template<typename QueueType> class BoundedQueueTest : public ::testing::Test
+{
+};
+
+using BoundedQueueTypes = ::testing::Types<JobSystem::SpscQueue<int>, JobSystem::MpscQueue<int>, JobSystem::SpmcQueue<int>, JobSystem::MpmcQueue<int>,
+                                           JobSystem::SpscQueue<int, 16>, JobSystem::MpmcQueue<int, 16>>;
+TYPED_TEST_SUITE(BoundedQueueTest, BoundedQueueTypes);
+
+TYPED_TEST(BoundedQueueTest, Bulk)
+{
+  TypeParam queue(16);
+  const std::vector<int> input = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+  int value = -1;
+  ASSERT_FALSE(queue.Pop(value));
+  // around the ring a few times, so the indices wrap
+  for (int lap = 0; lap < 3; ++lap) {
+    ASSERT_EQ(12u, queue.PushBulk(input.data(), input.size()));
+    ASSERT_EQ(4u, queue.PushBulk(input.data(), input.size()));
+    ASSERT_FALSE(queue.Push(-1));
+    ASSERT_EQ(16u, queue.Size());
+
+    std::vector<int> output(32, -1);
+    ASSERT_TRUE(queue.Pop(output[0]));
+    ASSERT_EQ(9u, queue.PopBulk(output.data() + 1, 9));
+    ASSERT_EQ(6u, queue.PopBulk(output.data() + 10, 32));
+    ASSERT_EQ(0u, queue.PopBulk(output.data(), 32));
+    ASSERT_TRUE(queue.IsEmpty());
+    for (size_t i = 0; i < 16; ++i) { ASSERT_EQ(input[i % 12], output[i]) << i; }
+  }
+}
+
+TYPED_TEST(BoundedQueueTest, Concurrent)
+{
+  constexpr int itemCount = 100000;
+  TypeParam queue(16);
+
+  // as many threads at either end as the queue allows
+  const unsigned numThreads = std::max(4u, std::thread::hardware_concurrency());
+  const unsigned numProducers = TypeParam::isSharedByProducers ? numThreads / 2 : 1;
+  const unsigned numConsumers = TypeParam::isSharedByConsumers ? numThreads / 2 : 1;
+  std::vector<std::atomic<int>> seen(itemCount);
+  std::atomic<int> numTaken{ 0 };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < numProducers; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int item = static_cast<int>(i); item < itemCount; item += static_cast<int>(numProducers)) {
+        while (!queue.Push(item)) std::this_thread::yield();
+      }
+    });
+  }
+  for (unsigned i = 0; i < numConsumers; ++i) {
+    threads.emplace_back([&, i]() {
+      int items[3];
+      int last = -1;
+      while (numTaken.load() < itemCount) {
+        // single and bulk pops in turns
+        const size_t count = i % 2 ? queue.PopBulk(items, 3) : (queue.Pop(items[0]) ? 1 : 0);
+        for (size_t j = 0; j < count; ++j) {
+          seen[static_cast<size_t>(items[j])]++;
+          // one producer and one consumer keep the order
+          if (numProducers == 1 && numConsumers == 1) ASSERT_LT(last, items[j]);
+          last = items[j];
+        }
+        numTaken += static_cast<int>(count);
+        if (!count) std::this_thread::yield();
+      }
+    });
+  }
+  for (auto & thread : threads) { thread.join(); }
+
+  for (int i = 0; i < itemCount; ++i) { ASSERT_EQ(1, seen[static_cast<size_t>(i)].load()) << i; }
+}
+
+TEST(BoundedQueue, StaticCapacity)
+{
+  // the cells are part of the queue, and only a constant capacity goes without a size
+  static_assert(sizeof(JobSystem::MpmcQueue<int, 64>) > 64 * sizeof(int), "Cells should be inline");
+  static_assert(std::is_default_constructible<JobSystem::SpscQueue<int, 16>>::value, "");
+  static_assert(!std::is_default_constructible<JobSystem::SpscQueue<int>>::value, "");
+
+  JobSystem::SpscQueue<int, 16> queue;
+  ASSERT_EQ(16u, queue.Capacity());
+  for (int i = 0; i < 16; ++i) { ASSERT_TRUE(queue.Push(i)); }
+  ASSERT_FALSE(queue.Push(-1));
+  int value = -1;
+  ASSERT_TRUE(queue.Pop(value));
+  ASSERT_EQ(0, value);
+}
+
+TEST(WorkStealingQueue, Overflow)
+{
+  JobSystem::WorkStealingQueue<int> queue(16);
+  for (size_t i = 0; i < queue.Capacity(); ++i) { ASSERT_TRUE(queue.Push(static_cast<int>(i))); }
+
+  ASSERT_FALSE(queue.Push(-1));
+}
+
+TEST(WorkStealingQueue, OwnerIsLifoStealerIsFifo)
+{
+  JobSystem::WorkStealingQueue<int> queue(16);
+  for (int i = 0; i < 4; ++i) { ASSERT_TRUE(queue.Push(i)); }
+
+  int value = -1;
+  ASSERT_TRUE(queue.Pop(value));
+  ASSERT_EQ(3, value);
+  ASSERT_TRUE(queue.Steal(value));
+  ASSERT_EQ(0, value);
+  ASSERT_TRUE(queue.Pop(value));
+  ASSERT_EQ(2, value);
+  ASSERT_TRUE(queue.Steal(value));
+  ASSERT_EQ(1, value);
+
+  ASSERT_FALSE(queue.Pop(value));
+  ASSERT_FALSE(queue.Steal(value));
+  ASSERT_TRUE(queue.IsEmpty());
+}
+
+TEST(WorkStealingQueue, ConcurrentSteal)
+{
+  constexpr int itemCount = 100000;
+  JobSystem::WorkStealingQueue<int> queue(1024);
+
+  const unsigned numThieves = std::max(2u, std::thread::hardware_concurrency()) - 1;
+  std::vector<std::atomic<int>> seen(itemCount);
+  std::atomic<bool> isDone{ false };
+
+  std::vector<std::thread> thieves;
+  for (unsigned i = 0; i < numThieves; ++i) {
+    thieves.emplace_back([&]() {
+      int value = 0;
+      while (!isDone) {
+        if (queue.Steal(value)) seen[static_cast<size_t>(value)]++;
+      }
+    });
+  }
+
+  // owner pushes everything, and pops every third item itself
+  int value = 0;
+  for (int i = 0; i < itemCount; ++i) {
+    while (!queue.Push(i)) {
+      if (queue.Pop(value)) seen[static_cast<size_t>(value)]++;
+    }
+    if (i % 3 == 0 && queue.Pop(value)) seen[static_cast<size_t>(value)]++;
+  }
+  while (queue.Pop(value)) seen[static_cast<size_t>(value)]++;
+
+  isDone = true;
+  for (auto & thief : thieves) { thief.join(); }
+
+  for (int i = 0; i < itemCount; ++i) { ASSERT_EQ(1, seen[static_cast<size_t>(i)].load()) << i; }
+}
+
+TEST(WorkStealingQueue, PushBulk)
+{
+  JobSystem::WorkStealingQueue<int> queue(16);
+  const std::vector<int> input = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+  ASSERT_EQ(12u, queue.PushBulk(input.data(), input.size()));
+  ASSERT_EQ(4u, queue.PushBulk(input.data(), input.size()));
+  ASSERT_EQ(16u, queue.Size());
+
+  int value = -1;
+  ASSERT_TRUE(queue.Steal(value));
+  ASSERT_EQ(0, value);
+  ASSERT_TRUE(queue.Pop(value));
+  ASSERT_EQ(3, value);
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+
+#include <ThreadPool/TaskGraph.h>
+
+using JobSystem::Internal::TaskGraph;
+using JobSystem::Internal::ThreadPool;
+using JobSystem::Internal::ThreadPoolConfig;
+
+TEST(TaskGraph, RunMany)
+{
+  // Given a diamond a -> (b, c) -> d
+  ThreadPool threadPool(std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 2);
+  TaskGraph graph(threadPool);
+
+  std::atomic<int> step{ 0 };
+  std::atomic<int> order[4];
+  std::atomic<int> runs[4];
+  for (int i = 0; i < 4; ++i) {
+    order[i] = -1;
+    runs[i] = 0;
+  }
+
+  TaskGraph::NodeId nodes[4];
+  for (int i = 0; i < 4; ++i) {
+    nodes[i] = graph.AddNode([&, i]() {
+      order[i] = step++;
+      runs[i]++;
+    });
+  }
+  graph.AddEdge(nodes[0], nodes[1]);
+  graph.AddEdge(nodes[0], nodes[2]);
+  graph.AddEdge(nodes[1], nodes[3]);
+  graph.AddEdge(nodes[2], nodes[3]);
+  graph.Compile();
+
+  // When
+  for (int run = 1; run <= 100; ++run) {
+    step = 0;
+    graph.Run();
+    graph.Wait();
+
+    // Then
+    ASSERT_FALSE(graph.IsRunning());
+    ASSERT_EQ(0, order[0].load());
+    ASSERT_LT(order[0].load(), order[1].load());
+    ASSERT_LT(order[0].load(), order[2].load());
+    ASSERT_EQ(3, order[3].load());
+    for (int i = 0; i < 4; ++i) { ASSERT_EQ(run, runs[i].load()); }
+  }
+}
+
+TEST(TaskGraph, RunBackToBack)
+{
+  for (bool useFibers : { false, true }) {
+    // Given a -> (b, c), so the root completes on whichever worker finishes last
+    ThreadPoolConfig config;
+    config.useFibers = useFibers;
+    ThreadPool threadPool(2, config);
+    TaskGraph graph(threadPool);
+
+    std::atomic<int> runs{ 0 };
+    const TaskGraph::NodeId first = graph.AddNode([&runs]() { runs++; });
+    graph.AddEdge(first, graph.AddNode([&runs]() { runs++; }));
+    graph.AddEdge(first, graph.AddNode([&runs]() { runs++; }));
+    graph.Compile();
+
+    // When the next run starts as soon as the previous one is done
+    constexpr int numRuns = 5000;
+    for (int run = 0; run < numRuns; ++run) {
+      graph.Run();
+      graph.Wait();
+    }
+
+    // Then
+    ASSERT_FALSE(graph.IsRunning()) << useFibers;
+    ASSERT_EQ(3 * numRuns, runs.load()) << useFibers;
+  }
+}
+
+TEST(TaskGraph, Subgraph)
+{
+  // Given a -> b -> c
+  ThreadPool threadPool(2);
+  TaskGraph graph(threadPool);
+
+  std::atomic<int> runs[3];
+  TaskGraph::NodeId nodes[3];
+  for (int i = 0; i < 3; ++i) {
+    runs[i] = 0;
+    nodes[i] = graph.AddNode([&, i]() { runs[i]++; });
+  }
+  graph.AddEdge(nodes[0], nodes[1]);
+  graph.AddEdge(nodes[1], nodes[2]);
+  const TaskGraph::SubgraphId tail = graph.AddSubgraph({ nodes[1], nodes[2] });
+  graph.Compile();
+
+  // When only running the tail, b has no dependency left
+  graph.Run(tail);
+  graph.Wait();
+
+  // Then
+  ASSERT_EQ(0, runs[0].load());
+  ASSERT_EQ(1, runs[1].load());
+  ASSERT_EQ(1, runs[2].load());
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <array>
+
+#include <ThreadPool/TaskScheduler.h>
+
+using JobSystem::Future;
+using JobSystem::TaskScheduler;
+
+TEST(TaskScheduler, Async)
+{
+  TaskScheduler scheduler;
+
+  Future<int> future = scheduler.Async([](int a, int b) { return a + b; }, 40, 2);
+  ASSERT_TRUE(future.IsValid());
+  ASSERT_EQ(42, future.Get());
+  ASSERT_FALSE(future.IsValid());
+}
+
+TEST(TaskScheduler, AsyncVoid)
+{
+  TaskScheduler scheduler;
+
+  std::atomic<int> counter{ 0 };
+  Future<void> future = scheduler.Async([&counter]() { counter++; });
+  future.Get();
+  ASSERT_EQ(1, counter.load());
+}
+
+TEST(TaskScheduler, AsyncLargeResult)
+{
+  TaskScheduler scheduler;
+
+  // does not fit into a pooled state
+  auto future = scheduler.Async([](size_t value) {
+    std::array<size_t, 32> result = {};
+    result.fill(value);
+    return result;
+  }, size_t{ 7 });
+  const auto result = future.Get();
+  ASSERT_EQ(7u, result[31]);
+}
+
+TEST(TaskScheduler, AsyncMany)
+{
+  TaskScheduler scheduler;
+
+  std::vector<Future<std::string>> futures;
+  for (int i = 0; i < 1000; ++i) {
+    futures.push_back(scheduler.Async([](int value) { return std::to_string(value); }, i));
+  }
+  for (int i = 0; i < 1000; ++i) { ASSERT_EQ(std::to_string(i), futures[static_cast<size_t>(i)].Get()); }
+}
+
+TEST(TaskScheduler, AsyncNested)
+{
+  TaskScheduler scheduler;
+
+  // Get() inside a job helps executing instead of blocking the worker
+  auto future = scheduler.Async([&scheduler]() {
+    auto inner = scheduler.Async([]() { return 21; });
+    return inner.Get() * 2;
+  });
+  ASSERT_EQ(42, future.Get());
+}
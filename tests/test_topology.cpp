@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <set>
+#include <thread>
+
+#include <ThreadPool/CpuTopology.h>
+#include <ThreadPool/ThreadPool.h>
+
+using JobSystem::CpuDistance;
+using JobSystem::CpuTopology;
+using JobSystem::Internal::Job;
+using JobSystem::Internal::ThreadPool;
+using JobSystem::Internal::ThreadPoolConfig;
+
+TEST(CpuTopology, ParseCpuList)
+{
+  ASSERT_EQ(std::vector<uint32_t>({ 0, 1, 2, 3, 8, 10, 11 }), CpuTopology::ParseCpuList("0-3,8,10-11"));
+  ASSERT_EQ(std::vector<uint32_t>({ 5 }), CpuTopology::ParseCpuList("5"));
+  ASSERT_TRUE(CpuTopology::ParseCpuList("").empty());
+  ASSERT_EQ(std::vector<uint32_t>({ 0, 1, 4 }), CpuTopology::ParseCpuList("0-1\n, 4 \n"));
+  // malformed entries are skipped instead of throwing
+  ASSERT_TRUE(CpuTopology::ParseCpuList("-").empty());
+  ASSERT_TRUE(CpuTopology::ParseCpuList(" ").empty());
+  ASSERT_EQ(std::vector<uint32_t>({ 2 }), CpuTopology::ParseCpuList("3-,2,-5,1--2,x,9 9,99999999999"));
+}
+
+TEST(CpuTopology, Discover)
+{
+  // Given
+  const CpuTopology topology = CpuTopology::Discover();
+
+  // Then
+  ASSERT_LT(0u, topology.NumCpus());
+  for (size_t i = 0; i < topology.NumCpus(); ++i) {
+    ASSERT_EQ(CpuDistance::Same, topology.Distance(i, i));
+    for (size_t j = 0; j < topology.NumCpus(); ++j) { ASSERT_EQ(topology.Distance(i, j), topology.Distance(j, i)); }
+  }
+
+  // every cpu gets placed once, first threads of the cores before SMT siblings
+  const std::vector<size_t> order = topology.PlacementOrder();
+  ASSERT_EQ(topology.NumCpus(), std::set<size_t>(order.begin(), order.end()).size());
+  for (size_t i = 1; i < order.size(); ++i) { ASSERT_LE(topology.Cpus()[order[i - 1]].thread, topology.Cpus()[order[i]].thread); }
+}
+
+TEST(CpuTopology, PinnedPool)
+{
+  // Given
+  ThreadPoolConfig config;
+  config.pinThreads = true;
+  ThreadPool threadPool(4, config);
+
+  // When
+  std::atomic<int> counter{ 0 };
+  Job * root = threadPool.CreateJob([]() {});
+  for (int i = 0; i < 1000; ++i) { threadPool.Schedule(threadPool.CreateJobAsChild(root, [&counter]() { counter++; })); }
+  threadPool.Schedule(root);
+  threadPool.Wait(root);
+
+  // Then
+  ASSERT_EQ(1000, counter.load());
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <ThreadPool/ThreadPool.h>
+#include <ThreadPool/TraceBuffer.h>
+
+using JobSystem::Internal::Job;
+using JobSystem::Internal::ThreadPool;
+using JobSystem::Internal::ThreadPoolConfig;
+using JobSystem::Internal::TraceBuffer;
+using JobSystem::Internal::TraceEventType;
+
+TEST(TraceBuffer, KeepsNewestEvents)
+{
+  // Given
+  TraceBuffer buffer(5);
+  ASSERT_EQ(8u, buffer.Capacity());
+
+  // When
+  for (uint16_t i = 0; i < 20; ++i) { buffer.Record(TraceEventType::JobBegin, 0, i); }
+  const auto events = buffer.Snapshot();
+
+  // Then
+  ASSERT_EQ(8u, events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    ASSERT_EQ(12u + i, events[i].label);
+    ASSERT_EQ(TraceEventType::JobBegin, events[i].type);
+  }
+  for (size_t i = 1; i < events.size(); ++i) { ASSERT_LE(events[i - 1].timestamp, events[i].timestamp); }
+}
+
+TEST(TraceBuffer, DumpTrace)
+{
+  // Given
+  ThreadPoolConfig config;
+  config.traceEventsPerWorker = 1024;
+  ThreadPool threadPool(2, config);
+  const uint16_t label = threadPool.RegisterTraceLabel("trace \"test\" job");
+
+  // When
+  Job * root = threadPool.CreateJob([]() {});
+  for (int i = 0; i < 50; ++i) {
+    Job * job = threadPool.CreateJobAsChild(root, []() {});
+    ThreadPool::SetTraceLabel(job, label);
+    threadPool.Schedule(job);
+  }
+  threadPool.Schedule(root);
+  threadPool.Wait(root);
+  const std::string path = ::testing::TempDir() + "trace_test.json";
+  ASSERT_TRUE(threadPool.DumpTrace(path));
+
+  // Then
+  std::stringstream content;
+  {
+    std::ifstream file(path);
+    content << file.rdbuf();
+  }
+  std::remove(path.c_str());
+  const std::string json = content.str();
+  ASSERT_NE(std::string::npos, json.find("\"traceEvents\""));
+  ASSERT_NE(std::string::npos, json.find("\"Main thread\""));
+  ASSERT_NE(std::string::npos, json.find("\"trace \\\"test\\\" job\""));
+  ASSERT_NE(std::string::npos, json.find("\"name\":\"wait\""));
+  ASSERT_FALSE(threadPool.DumpTrace("no/such/directory/trace.json"));
+}
@@ -19,3 +19,15 @@ CPMAddPackage(
   GIT_TAG v1.4.2
   VERSION 1.4.2
 )
+
+if (BUILD_BENCHMARKS)
+  CPMAddPackage(
+    NAME benchmark
+    GITHUB_REPOSITORY google/benchmark
+    GIT_TAG v1.7.1
+    VERSION 1.7.1
+    OPTIONS
+    "BENCHMARK_ENABLE_TESTING OFF"
+    "BENCHMARK_ENABLE_INSTALL OFF"
+  )
+endif ()